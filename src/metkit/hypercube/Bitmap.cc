@@ -0,0 +1,380 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "metkit/hypercube/Bitmap.h"
+#include "metkit/mars/BitCount.h"
+
+namespace metkit {
+namespace hypercube {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static constexpr uint64_t chunkBits = 16;
+static constexpr uint64_t chunkSize = uint64_t(1) << chunkBits;
+
+/// Largest list of positions, beyond which words take less space
+static constexpr uint32_t maxPositions = 4096;
+
+Bitmap::Chunk::Chunk(uint32_t size, bool value) :
+    kind_(value ? Full : Empty), size_(size), count_(value ? size : 0) {}
+
+bool Bitmap::Chunk::test(uint32_t i) const {
+    switch (kind_) {
+        case Empty:
+            return false;
+        case Full:
+            return true;
+        case Array:
+            return std::binary_search(positions_.begin(), positions_.end(), i);
+        case Inverted:
+            return !std::binary_search(positions_.begin(), positions_.end(), i);
+        case Dense:
+            return (words_[i >> 6] >> (i & 63)) & 1;
+    }
+    return false;
+}
+
+bool Bitmap::Chunk::assign(uint32_t i, bool value) {
+    if (test(i) == value) {
+        return false;
+    }
+
+    switch (kind_) {
+        case Empty:
+        case Full:
+            // A list of the one bit that differs
+            positions_.assign(1, i);
+            kind_ = (kind_ == Empty) ? Array : Inverted;
+            break;
+
+        case Array:
+        case Inverted:
+            // Array lists the set bits, Inverted the clear ones
+            if (value == (kind_ == Array)) {
+                positions_.insert(std::lower_bound(positions_.begin(), positions_.end(), i), i);
+            }
+            else {
+                positions_.erase(std::lower_bound(positions_.begin(), positions_.end(), i));
+            }
+            break;
+
+        case Dense:
+            words_[i >> 6] ^= uint64_t(1) << (i & 63);
+            for (size_t k = (i >> 9) + 1; k < ranks_.size(); ++k) {
+                ranks_[k] = value ? ranks_[k] + 1 : ranks_[k] - 1;
+            }
+            break;
+    }
+
+    count_ = value ? count_ + 1 : count_ - 1;
+    normalise();
+    return true;
+}
+
+void Bitmap::Chunk::normalise() {
+    Kind kind = Dense;
+    if (count_ == 0) {
+        kind = Empty;
+    }
+    else if (count_ == size_) {
+        kind = Full;
+    }
+    else if (count_ <= maxPositions) {
+        kind = Array;
+    }
+    else if (size_ - count_ <= maxPositions) {
+        kind = Inverted;
+    }
+
+    if (kind == kind_) {
+        return;
+    }
+
+    std::vector<uint64_t> w = words();
+
+    positions_.clear();
+    positions_.shrink_to_fit();
+    words_.clear();
+    words_.shrink_to_fit();
+    ranks_.clear();
+    ranks_.shrink_to_fit();
+
+    if (kind == Dense) {
+        std::swap(words_, w);
+        index();
+    }
+    else if (kind == Array || kind == Inverted) {
+        // Lists the bits that are set for Array, clear for Inverted
+        uint64_t flip = (kind == Array) ? 0 : ~uint64_t(0);
+        positions_.reserve(kind == Array ? count_ : size_ - count_);
+        for (uint32_t k = 0; k < w.size(); ++k) {
+            uint64_t v = w[k] ^ flip;
+            while (v) {
+                uint32_t i = (k << 6) + mars::countTrailingZeros(v);
+                if (i >= size_) {
+                    break;
+                }
+                positions_.push_back(i);
+                v &= v - 1;
+            }
+        }
+    }
+
+    kind_ = kind;
+}
+
+std::vector<uint64_t> Bitmap::Chunk::words() const {
+    if (kind_ == Dense) {
+        return words_;
+    }
+
+    bool full = (kind_ == Full || kind_ == Inverted);
+    std::vector<uint64_t> w((size_ + 63) / 64, full ? ~uint64_t(0) : 0);
+    if (full && (size_ & 63)) {
+        w.back() = (uint64_t(1) << (size_ & 63)) - 1;
+    }
+
+    for (uint16_t i : positions_) {
+        w[i >> 6] ^= uint64_t(1) << (i & 63);
+    }
+    return w;
+}
+
+void Bitmap::Chunk::index() {
+    ranks_.assign((words_.size() + 7) / 8, 0);
+    uint32_t r = 0;
+    for (size_t w = 0; w < words_.size(); ++w) {
+        if ((w & 7) == 0) {
+            ranks_[w >> 3] = r;
+        }
+        r += mars::popcount(words_[w]);
+    }
+}
+
+uint32_t Bitmap::Chunk::rank(uint32_t i) const {
+    switch (kind_) {
+        case Empty:
+            return 0;
+        case Full:
+            return i;
+        case Array:
+            return std::lower_bound(positions_.begin(), positions_.end(), i) - positions_.begin();
+        case Inverted:
+            return i - (std::lower_bound(positions_.begin(), positions_.end(), i) - positions_.begin());
+        case Dense:
+            break;
+    }
+
+    if (i == size_) {
+        return count_;
+    }
+
+    uint32_t w = i >> 6;
+    uint32_t r = ranks_[w >> 3];
+    for (uint32_t k = w & ~uint32_t(7); k < w; ++k) {
+        r += mars::popcount(words_[k]);
+    }
+    if (i & 63) {
+        r += mars::popcount(words_[w] & ((uint64_t(1) << (i & 63)) - 1));
+    }
+    return r;
+}
+
+uint32_t Bitmap::Chunk::select(uint32_t rank) const {
+    ASSERT(rank < count_);
+
+    switch (kind_) {
+        case Empty:
+            break;
+        case Full:
+            return rank;
+        case Array:
+            return positions_[rank];
+        case Inverted: {
+            // positions_[j] - j set bits come before the j-th clear bit: the bit of that rank comes after as
+            // many clear bits as have no more set bits before them than the rank
+            size_t lo = 0;
+            size_t hi = positions_.size();
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (positions_[mid] - mid <= rank) {
+                    lo = mid + 1;
+                }
+                else {
+                    hi = mid;
+                }
+            }
+            return rank + lo;
+        }
+        case Dense: {
+            size_t sb  = std::upper_bound(ranks_.begin(), ranks_.end(), rank) - ranks_.begin() - 1;
+            uint32_t r = rank - ranks_[sb];
+            size_t w   = sb << 3;
+            for (;; ++w) {
+                uint32_t n = mars::popcount(words_[w]);
+                if (r < n) {
+                    break;
+                }
+                r -= n;
+            }
+            uint64_t v = words_[w];
+            for (; r > 0; --r) {
+                v &= v - 1;
+            }
+            return (w << 6) + mars::countTrailingZeros(v);
+        }
+    }
+    return size_;
+}
+
+uint32_t Bitmap::Chunk::next(uint32_t i) const {
+    if (i >= size_) {
+        return size_;
+    }
+
+    switch (kind_) {
+        case Empty:
+            return size_;
+        case Full:
+            return i;
+        case Array: {
+            auto j = std::lower_bound(positions_.begin(), positions_.end(), i);
+            return j == positions_.end() ? size_ : *j;
+        }
+        case Inverted: {
+            auto j = std::lower_bound(positions_.begin(), positions_.end(), i);
+            while (j != positions_.end() && *j == i) {
+                ++j;
+                ++i;
+            }
+            return i;
+        }
+        case Dense:
+            break;
+    }
+
+    size_t w   = i >> 6;
+    uint64_t v = words_[w] & (~uint64_t(0) << (i & 63));
+    while (!v) {
+        if (++w == words_.size()) {
+            return size_;
+        }
+        v = words_[w];
+    }
+    return (w << 6) + mars::countTrailingZeros(v);
+}
+
+size_t Bitmap::Chunk::footprint() const {
+    return sizeof(*this) + positions_.capacity() * sizeof(uint16_t) + words_.capacity() * sizeof(uint64_t) +
+           ranks_.capacity() * sizeof(uint16_t);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Bitmap::Bitmap(uint64_t size, bool value) : size_(size), count_(value ? size : 0) {
+    chunks_.reserve((size + chunkSize - 1) >> chunkBits);
+    for (uint64_t start = 0; start < size; start += chunkSize) {
+        chunks_.emplace_back(uint32_t(std::min(chunkSize, size - start)), value);
+    }
+
+    tree_.assign(chunks_.size() + 1, 0);
+    for (size_t k = 1; k < tree_.size(); ++k) {
+        tree_[k] += chunks_[k - 1].count();
+        size_t parent = k + (k & -k);
+        if (parent < tree_.size()) {
+            tree_[parent] += tree_[k];
+        }
+    }
+}
+
+bool Bitmap::test(uint64_t i) const {
+    ASSERT(i < size_);
+    return chunks_[i >> chunkBits].test(i & (chunkSize - 1));
+}
+
+bool Bitmap::assign(uint64_t i, bool value) {
+    ASSERT(i < size_);
+    if (!chunks_[i >> chunkBits].assign(i & (chunkSize - 1), value)) {
+        return false;
+    }
+    count_ = value ? count_ + 1 : count_ - 1;
+
+    // Adding the two's complement of 1 takes it away
+    uint64_t delta = value ? 1 : ~uint64_t(0);
+    for (size_t k = (i >> chunkBits) + 1; k < tree_.size(); k += (k & -k)) {
+        tree_[k] += delta;
+    }
+    return true;
+}
+
+uint64_t Bitmap::before(size_t c) const {
+    uint64_t r = 0;
+    for (size_t k = c; k > 0; k -= (k & -k)) {
+        r += tree_[k];
+    }
+    return r;
+}
+
+uint64_t Bitmap::rank(uint64_t i) const {
+    ASSERT(i <= size_);
+    uint64_t c = i >> chunkBits;
+    if (c == chunks_.size()) {
+        return count_;
+    }
+    return before(c) + chunks_[c].rank(i & (chunkSize - 1));
+}
+
+uint64_t Bitmap::select(uint64_t rank) const {
+    if (rank >= count_) {
+        return size_;
+    }
+
+    // Descends the tree to the most chunks with no more than rank set bits in them; the next one has the bit
+    size_t c = 0;
+    size_t step = 1;
+    while (step * 2 < tree_.size()) {
+        step *= 2;
+    }
+    for (; step > 0; step /= 2) {
+        if (c + step < tree_.size() && tree_[c + step] <= rank) {
+            c += step;
+            rank -= tree_[c];
+        }
+    }
+    return (uint64_t(c) << chunkBits) + chunks_[c].select(rank);
+}
+
+uint64_t Bitmap::next(uint64_t i) const {
+    for (uint64_t c = i >> chunkBits; c < chunks_.size(); ++c) {
+        uint32_t start = (c == (i >> chunkBits)) ? (i & (chunkSize - 1)) : 0;
+        uint32_t n     = chunks_[c].next(start);
+        if (n < chunkSize && (c << chunkBits) + n < size_) {
+            return (c << chunkBits) + n;
+        }
+    }
+    return size_;
+}
+
+size_t Bitmap::footprint() const {
+    size_t n = sizeof(*this) + tree_.capacity() * sizeof(uint64_t);
+    for (const Chunk& c : chunks_) {
+        n += c.footprint();
+    }
+    return n;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace hypercube
+}  // namespace metkit
@@ -0,0 +1,139 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   Bitmap.h
+/// @date   Oct 2026
+
+#ifndef metkit_hypercube_Bitmap_H
+#define metkit_hypercube_Bitmap_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace metkit {
+namespace hypercube {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Compressed bitset with 64-bit positions, answering rank (set bits before a position) and select (position of
+/// the n-th set bit) quickly.
+///
+/// As in roaring bitmaps, the bits are split into chunks of 65536, each stored according to its density: nothing
+/// when all its bits are clear or all set, a sorted list of the set bits (or of the clear bits) when there are
+/// at most 4096 of them, and 64-bit words otherwise. A chunk changes representation as bits are set or cleared,
+/// so a large bitmap with few set (or few clear) bits stays small.
+///
+/// The number of set bits before each 512-bit superblock of a chunk of words is kept up to date as bits change,
+/// as are the counts of the chunks, in a Fenwick tree. rank() is then a binary search in a list or a handful of
+/// popcounts, after summing O(log c) counts of the c chunks, and select() descends the tree. A change costs at
+/// most a shift of a list of 4096 positions, or 128 superblock counts and O(log c) tree nodes, plus the
+/// conversion when the chunk changes representation. The const methods do not modify anything, so they can be
+/// called from several threads at once, as long as none of them changes the bitmap.
+
+class Bitmap {
+public:  // methods
+    explicit Bitmap(uint64_t size = 0, bool value = false);
+
+    uint64_t size() const { return size_; }
+
+    /// Number of set bits
+    uint64_t count() const { return count_; }
+
+    bool test(uint64_t i) const;
+
+    /// Sets bit i, returning false if it was already set
+    bool set(uint64_t i) { return assign(i, true); }
+
+    /// Clears bit i, returning false if it was already clear
+    bool reset(uint64_t i) { return assign(i, false); }
+
+    /// Number of set bits before position i
+    uint64_t rank(uint64_t i) const;
+
+    /// Position of the set bit of the given rank, or size() if there are not as many set bits
+    uint64_t select(uint64_t rank) const;
+
+    /// Position of the first set bit at or after i, or size() if there is none
+    uint64_t next(uint64_t i) const;
+
+    /// Approximate memory used, in bytes
+    size_t footprint() const;
+
+private:  // types
+    class Chunk {
+    public:
+        enum Kind : uint8_t
+        {
+            Empty,
+            Full,
+            Array,
+            Inverted,
+            Dense
+        };
+
+        Chunk(uint32_t size, bool value);
+
+        Kind kind() const { return kind_; }
+        uint32_t count() const { return count_; }
+
+        bool test(uint32_t i) const;
+        bool assign(uint32_t i, bool value);
+        uint32_t rank(uint32_t i) const;
+        uint32_t select(uint32_t rank) const;
+
+        /// First set bit at or after i, or the size of the chunk
+        uint32_t next(uint32_t i) const;
+
+        size_t footprint() const;
+
+    private:
+        /// Chooses the representation for the current number of set bits
+        void normalise();
+
+        /// The bits of the chunk as words
+        std::vector<uint64_t> words() const;
+
+        /// Counts the set bits before each superblock of a chunk of words
+        void index();
+
+        Kind kind_;
+        uint32_t size_;
+        uint32_t count_;
+
+        /// Array: the set bits; Inverted: the clear bits
+        std::vector<uint16_t> positions_;
+
+        /// Dense: the bits, and the set bits before each superblock of 8 words
+        std::vector<uint64_t> words_;
+        std::vector<uint16_t> ranks_;
+    };
+
+private:  // methods
+    bool assign(uint64_t i, bool value);
+
+    /// Set bits in the chunks before chunk c
+    uint64_t before(size_t c) const;
+
+private:  // members
+    uint64_t size_;
+    uint64_t count_;
+    std::vector<Chunk> chunks_;
+
+    /// Fenwick tree of the counts of the chunks: node k (from 1) holds the set bits of chunks [k - (k & -k), k)
+    std::vector<uint64_t> tree_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace hypercube
+}  // namespace metkit
+
+#endif
@@ -11,10 +11,14 @@
 #include "metkit/hypercube/HyperCube.h"
 
 #include <algorithm>
+#include <iterator>
+#include <unordered_map>
 
 #include "eckit/exception/Exceptions.h"
 #include "eckit/parser/YAMLParser.h"
+#include "eckit/types/Types.h"
 
+#include "metkit/mars/Keyword.h"
 #include "metkit/mars/MarsLanguage.h"
 #include "metkit/mars/MarsRequest.h"
 #include "metkit/mars/Type.h"
@@ -23,7 +27,7 @@ namespace metkit {
 namespace hypercube {
 
 static metkit::mars::Type& type(const std::string& name) {
-    static metkit::mars::MarsLanguage language("retrieve");
+    static const metkit::mars::MarsLanguage& language = metkit::mars::MarsLanguage::instance("retrieve");
     return *language.type(name);
 }
 
@@ -60,19 +64,29 @@ private: // members
 
 class Axis {
 public:
-    Axis(const std::string& name, const std::vector<std::string>& values) :
-        name_(name), values_(values), type_(type(name)) {}
+    Axis(const std::string& name, const metkit::mars::Parameter& values) :
+        name_(name), keyword_(metkit::mars::Keyword::id(name)), values_(values), type_(type(name)) {
+        const std::vector<std::string>& v = values_.values();
+        index_.reserve(v.size());
+        for (size_t i = 0; i < v.size(); ++i) {
+            // The first of duplicated values is the one found
+            index_.emplace(v[i], i);
+        }
+    }
 
+    /// Taken from the parameter, so that a range is sized without making its values
     size_t size() const { return values_.size(); }
 
     const std::string& name() const { return name_; }
 
-    int indexOf(const std::string& v) const {
-        auto j = std::find(values_.begin(), values_.end(), v);
-        if (j == values_.end()) {
-            return -1;
+    size_t keyword() const { return keyword_; }
+
+    size_t indexOf(const std::string& v) const {
+        auto j = index_.find(v);
+        if (j == index_.end()) {
+            return HyperCube::npos;
         }
-        return j - values_.begin();
+        return (*j).second;
     }
 
     const std::string& valueOf(size_t index) const {
@@ -81,34 +95,48 @@ public:
             oss << "Axis::valueOf no value for [axis=" << name() << ",index=" << index << "]";
             throw eckit::UserError(oss.str());
         }
-        return values_[index];
+        return values_.values()[index];
     }
 
 private:
     std::string name_;
-    std::vector<std::string> values_;
-    std::vector<bool> set_;
+    size_t keyword_;
+    metkit::mars::Parameter values_;
+    std::unordered_map<std::string, size_t> index_;
     metkit::mars::Type& type_;
 };
 
-HyperCube::HyperCube(const metkit::mars::MarsRequest& request) : verb_(request.verb()), cube_(std::vector<eckit::Ordinal>()) {
+constexpr size_t HyperCube::npos;
 
-    std::vector<eckit::Ordinal> dimensions;
+HyperCube::HyperCube(const metkit::mars::MarsRequest& request) : verb_(request.verb()) {
 
     for (auto& name : AxisOrder::instance().axes()) {
-        std::vector<std::string> values = request.values(name, true);
+        const metkit::mars::Parameter* values = request.parameter(metkit::mars::Keyword::id(name));
 
-        if (!values.empty()) {
-            Axis* a = new Axis(name, values);
+        if (values && values->size()) {
+            Axis* a = new Axis(name, *values);
             axes_.push_back(a);
             axesByName_[name] = a;
-            dimensions.push_back(values.size());
         }
     }
 
-    cube_  = eckit::HyperCube(dimensions);
-    count_ = cube_.count();
-    set_   = std::vector<bool>(count_, true);
+    strides_.resize(axes_.size());
+    size_t stride = 1;
+    for (size_t i = axes_.size(); i > 0; --i) {
+        strides_[i - 1] = stride;
+        size_t n        = axes_[i - 1]->size();
+        if (stride > (npos - 1) / n) {
+            for (auto& a : axes_) {
+                delete a;
+            }
+            std::ostringstream oss;
+            oss << "HyperCube: too many fields in request " << request;
+            throw eckit::UserError(oss.str());
+        }
+        stride *= n;
+    }
+
+    set_ = Bitmap(stride, true);
 }
 
 HyperCube::~HyperCube() {
@@ -118,168 +146,265 @@ HyperCube::~HyperCube() {
 }
 
 bool HyperCube::contains(const metkit::mars::MarsRequest& r) const {
-    int idx = indexOf(r);
-    return (idx >= 0) and set_[idx];
+    return contains(indexOf(r));
 }
 
-bool HyperCube::clear(int idx) {
-    if (idx < 0)
-        return false;
-    if (!set_[idx])
+bool HyperCube::contains(size_t idx) const {
+    return (idx != npos) and set_.test(idx);
+}
+
+bool HyperCube::clear(size_t idx) {
+    if (idx == npos)
         return false;
-    set_[idx] = false;
-    count_--;
-    return true;
+    return set_.reset(idx);
 }
 bool HyperCube::clear(const metkit::mars::MarsRequest& r) {
-    int idx = indexOf(r);
+    size_t idx = indexOf(r);
     return clear(idx);
 }
 
-int HyperCube::indexOf(const metkit::mars::MarsRequest& r) const {
+size_t HyperCube::indexOf(const metkit::mars::MarsRequest& r) const {
 
-    std::vector<eckit::Ordinal> coords;
+    size_t idx = 0;
 
-    for (auto& a : axes_) {
-        const std::vector<std::string>& values = r.values(a->name(), true);
-        if (values.size() == 0) {
+    for (size_t i = 0; i < axes_.size(); ++i) {
+        const Axis& a = *axes_[i];
+
+        const metkit::mars::Parameter* p = r.parameter(a.keyword());
+        if (!p || p->size() == 0) {
             std::ostringstream oss;
-            oss << "HyperCube::indexOf no value for [" << a->name() << "] in request " << r;
+            oss << "HyperCube::indexOf no value for [" << a.name() << "] in request " << r;
             throw eckit::UserError(oss.str());
         }
 
-        if (values.size() > 1) {
+        if (p->size() > 1) {
             std::ostringstream oss;
-            oss << "HyperCube::indexOf too many values for [" << a->name() << "] in request " << r;
+            oss << "HyperCube::indexOf too many values for [" << a.name() << "] in request " << r;
             throw eckit::UserError(oss.str());
         }
 
-        int n = a->indexOf(values[0]);
-        if (n < 0) {
-            return -1;
+        size_t n = a.indexOf(p->values()[0]);
+        if (n == npos) {
+            return npos;
         }
 
-        coords.push_back(n);
+        idx += n * strides_[i];
     }
 
-    return cube_.index(coords);
+    return idx;
 }
 
-enum requestRelation {
-    EMBEDDED,
-    ADIACENT,
-    DISJOINT
-};
+std::vector<size_t> HyperCube::indexOf(const std::vector<std::string>& names,
+                                       const std::vector<std::vector<std::string>>& fields) const {
 
-requestRelation getRelation(const metkit::mars::MarsRequest& base, const size_t& baseSize, const metkit::mars::MarsRequest& additional, const size_t additionalSize) {
+    // Position in the tuples of the value of each axis
+    std::vector<size_t> slots;
+    for (auto& a : axes_) {
+        auto j = std::find(names.begin(), names.end(), a->name());
+        if (j == names.end()) {
+            std::ostringstream oss;
+            oss << "HyperCube::indexOf no value for [" << a->name() << "] in " << names;
+            throw eckit::UserError(oss.str());
+        }
+        slots.push_back(j - names.begin());
+    }
 
-    metkit::mars::MarsRequest tmp(base);
-    tmp.merge(additional);
-    size_t sizeAfter = HyperCube(tmp).size();
+    std::vector<size_t> result;
+    result.reserve(fields.size());
 
-    if (sizeAfter == baseSize)
-        return requestRelation::EMBEDDED;
+    for (const auto& field : fields) {
+        ASSERT(field.size() == names.size());
 
-    if (baseSize + additionalSize == sizeAfter)
-        return requestRelation::ADIACENT;
+        size_t idx = 0;
+        for (size_t i = 0; idx != npos && i < axes_.size(); ++i) {
+            size_t n = axes_[i]->indexOf(field[slots[i]]);
+            idx      = (n == npos) ? npos : idx + n * strides_[i];
+        }
+        result.push_back(idx);
+    }
 
-    return requestRelation::DISJOINT;
+    return result;
 }
 
-bool mergeLast(std::vector<std::pair<metkit::mars::MarsRequest, size_t>>& requests) {
-    size_t last = requests.size()-1;
+namespace {
 
-    int candidateIdx = -1;
-    int candidateSize = -1;
-    requestRelation relation = requestRelation::DISJOINT;
+/// Values of each axis of a hyper-rectangle of the cube, as increasing indices
+using Box = std::vector<std::vector<size_t>>;
 
-    // check id the new request is embedded or adiacent to existing requests
-    for (size_t j = 0; j < requests.size()-1; j++) {
-        relation = std::min(relation, getRelation(requests[j].first, requests[j].second, requests[last].first, requests[last].second));
-        if (relation == requestRelation::EMBEDDED) {
-            requests.pop_back();
-            return false;
+struct ValuesHash {
+    size_t operator()(const std::vector<size_t>& v) const {
+        size_t h = v.size();
+        for (size_t x : v) {
+            h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
         }
-        if (relation == requestRelation::ADIACENT) {
-            // try to merge in the largest request
-            if (candidateSize == -1 || candidateSize < requests[j].second + requests[last].second) {
-                candidateIdx = j;
-                candidateSize = requests[j].second + requests[last].second;
-            }
+        return h;
+    }
+};
+
+struct BoxHash {
+    size_t operator()(const Box& b) const {
+        size_t h = 0;
+        for (const auto& v : b) {
+            h = h * 31 + ValuesHash()(v);
         }
+        return h;
     }
-    if (relation == requestRelation::EMBEDDED) {
-        requests.pop_back();
-        return false;
+};
+
+/// Rows of a cube grouped by the values of the last axis they hold, in order of first appearance
+class Rows {
+public:
+    void add(size_t row, const std::vector<size_t>& pattern) {
+        auto j = index_.find(pattern);
+        if (j == index_.end()) {
+            j = index_.emplace(pattern, groups_.size()).first;
+            groups_.emplace_back(pattern, std::vector<size_t>());
+        }
+        groups_[j->second].second.push_back(row);
     }
-    if (relation == requestRelation::ADIACENT && candidateIdx != -1) {
-        requests[candidateIdx].first.merge(requests[last].first);
-        requests[candidateIdx].second += requests[last].second;
-        requests.pop_back();
-        return true;
+
+    const std::vector<std::pair<std::vector<size_t>, std::vector<size_t>>>& groups() const { return groups_; }
+
+private:
+    std::unordered_map<std::vector<size_t>, size_t, ValuesHash> index_;
+    std::vector<std::pair<std::vector<size_t>, std::vector<size_t>>> groups_;
+};
+
+void decompose(const std::vector<size_t>& points, const std::vector<size_t>& sizes, size_t k, std::vector<Box>& boxes);
+
+/// Each group of rows holding the same values of axis k-1 is a box of the cube of the first k-1 axes, times those
+/// values
+void decompose(const Rows& rows, const std::vector<size_t>& sizes, size_t k, std::vector<Box>& boxes) {
+    for (const auto& g : rows.groups()) {
+        size_t first = boxes.size();
+        decompose(g.second, sizes, k - 1, boxes);
+        for (size_t j = first; j < boxes.size(); ++j) {
+            boxes[j].push_back(g.first);
+        }
     }
-    return false;
 }
 
+/// Splits points of the cube of the first k axes, given as increasing row-major indices, into disjoint boxes
+void decompose(const std::vector<size_t>& points, const std::vector<size_t>& sizes, size_t k, std::vector<Box>& boxes) {
+    if (k == 0) {
+        boxes.emplace_back();
+        return;
+    }
 
-std::vector<std::pair<metkit::mars::MarsRequest, size_t>> HyperCube::request(std::set<size_t> idxs) const {
-    size_t min = 1;
-    int minAxis = -1;
-    std::vector<std::map<eckit::Ordinal, std::set<size_t>>> axes(axes_.size());
+    size_t n = sizes[k - 1];
+    Rows rows;
+    std::vector<size_t> pattern;
+    for (size_t i = 0; i < points.size();) {
+        size_t row = points[i] / n;
+        pattern.clear();
+        while (i < points.size() && points[i] / n == row) {
+            pattern.push_back(points[i++] % n);
+        }
+        rows.add(row, pattern);
+    }
+
+    decompose(rows, sizes, k, boxes);
+}
 
-    if (idxs.size() > 1) {
-        std::vector<eckit::Ordinal> coords(axes_.size());
-        for (size_t idx: idxs) {
-            cube_.coordinates(idx, coords);
-            for(size_t j=0; j<axes_.size(); j++) {
-                axes[j][coords[j]].emplace(idx);
-                if (1 < axes[j].size() && (axes[j].size() < min || min == 1)) {
-                    min = axes[j].size();
-                    minAxis = j;
+/// Merges boxes that only differ on one axis, until no two do
+void merge(std::vector<Box>& boxes, size_t naxes) {
+    bool merged = true;
+    while (merged && boxes.size() > 1) {
+        merged = false;
+        for (size_t axis = 0; axis < naxes; ++axis) {
+            std::unordered_map<Box, size_t, BoxHash> index;
+            std::vector<Box> out;
+            for (auto& b : boxes) {
+                Box key(b);
+                key[axis].clear();
+                auto j = index.find(key);
+                if (j == index.end()) {
+                    index.emplace(std::move(key), out.size());
+                    out.push_back(std::move(b));
+                    continue;
                 }
+                // The boxes are disjoint, so are their values on that axis
+                std::vector<size_t>& values = out[j->second][axis];
+                std::vector<size_t> u;
+                u.reserve(values.size() + b[axis].size());
+                std::merge(values.begin(), values.end(), b[axis].begin(), b[axis].end(), std::back_inserter(u));
+                values.swap(u);
+                merged = true;
             }
+            boxes.swap(out);
         }
     }
-    // all requests are identical, returning just the first
-    if (min == 1)
-        return std::vector<std::pair<metkit::mars::MarsRequest, size_t>> {std::make_pair<metkit::mars::MarsRequest, size_t>(requestOf(*idxs.begin()), 1)};
-
-    auto it = axes[minAxis].begin();
-    std::vector<std::pair<metkit::mars::MarsRequest, size_t>> requests = request(it->second);
-    for(; it != axes[minAxis].end(); it++) {
-        std::vector<std::pair<metkit::mars::MarsRequest, size_t>> toAdd = request(it->second);
-        for(auto r: toAdd) {
-            requests.push_back(r);
-            while (mergeLast(requests));
-        }
-    }
-    return requests;
 }
 
+}  // namespace
+
 std::vector<metkit::mars::MarsRequest> HyperCube::vacantRequests() const {
 
+    std::vector<metkit::mars::MarsRequest> out;
     if (countVacant() == 0)
-        return std::vector<metkit::mars::MarsRequest>{};
+        return out;
 
-    std::set<size_t> idxs;
-    for(size_t i = 0; i < set_.size(); ++i) {
-        if (set_[i])
-            idxs.emplace(i);
+    std::vector<size_t> sizes;
+    for (const auto& a : axes_) {
+        sizes.push_back(a->size());
     }
 
-    std::vector<std::pair<metkit::mars::MarsRequest, size_t>> requests = request(idxs);
+    std::vector<Box> boxes;
+    if (countVacant() == size() || axes_.empty()) {
+        boxes.emplace_back(axes_.size());
+        for (size_t i = 0; i < axes_.size(); ++i) {
+            for (size_t j = 0; j < sizes[i]; ++j) {
+                boxes.back()[i].push_back(j);
+            }
+        }
+    }
+    else {
+        // The vacant fields are read row by row from the bitmap, rather than collected
+        size_t n = sizes.back();
+        Rows rows;
+        std::vector<size_t> pattern;
+        for (size_t i = set_.next(0); i < size();) {
+            size_t row = i / n;
+            pattern.clear();
+            for (; i < (row + 1) * n; i = set_.next(i + 1)) {
+                pattern.push_back(i - row * n);
+            }
+            rows.add(row, pattern);
+        }
+        decompose(rows, sizes, axes_.size(), boxes);
+        merge(boxes, axes_.size());
+    }
 
-    std::vector<metkit::mars::MarsRequest> out;
-    for (auto req: requests)
-        out.push_back(req.first);
+    out.reserve(boxes.size());
+    for (const Box& b : boxes) {
+        metkit::mars::MarsRequest request(verb_);
+        for (size_t i = 0; i < axes_.size(); ++i) {
+            std::vector<std::string> values;
+            values.reserve(b[i].size());
+            for (size_t j : b[i]) {
+                values.push_back(axes_[i]->valueOf(j));
+            }
+            request.values(axes_[i]->name(), std::move(values));
+        }
+        out.push_back(std::move(request));
+    }
     return out;
 }
 
+void HyperCube::coordinates(size_t index, std::vector<size_t>& coords) const {
+    ASSERT(index < size());
+    coords.resize(axes_.size());
+    for (size_t i = 0; i < axes_.size(); ++i) {
+        coords[i] = index / strides_[i];
+        index -= coords[i] * strides_[i];
+    }
+}
+
 metkit::mars::MarsRequest HyperCube::requestOf(size_t index) const {
     metkit::mars::MarsRequest request(verb_);
-    std::vector<eckit::Ordinal> coords(axes_.size());
+    std::vector<size_t> coords(axes_.size());
 
-    cube_.coordinates(index, coords);
+    coordinates(index, coords);
     for (size_t i=0; i<axes_.size(); i++) {
         request.setValue(axes_[i]->name(), axes_[i]->valueOf(coords[i]));
     }
@@ -287,25 +412,242 @@ metkit::mars::MarsRequest HyperCube::requestOf(size_t index) const {
 }
 
 size_t HyperCube::count() const {
-    return count_;
+    return set_.count();
 }
 size_t HyperCube::countVacant() const {
-    return count_;
+    return set_.count();
 }
 
 size_t HyperCube::fieldOrdinal(const metkit::mars::MarsRequest& r, bool noholes) const {
-    int idx = indexOf(r);
-    ASSERT(idx >= 0);
+    size_t idx = indexOf(r);
+    ASSERT(idx != npos);
     if (noholes) {
-        size_t p = 0;
-        for (size_t i = 0; i < idx; ++i) {
-            if (set_[i]) {
-                p++;
+        return set_.rank(idx);
+    }
+    return idx;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+/// Fields of two lists of requests, as boxes grouped by the axes they have values for. Values are numbered per
+/// axis in order of first appearance, so that boxes are compared and merged as in vacantRequests().
+class Operands {
+public:
+    Operands(const std::vector<metkit::mars::MarsRequest>& a, const std::vector<metkit::mars::MarsRequest>& b) :
+        verb_(!a.empty() ? a.front().verb() : (!b.empty() ? b.front().verb() : "retrieve")) {
+        add(a, a_);
+        add(b, b_);
+    }
+
+    /// The axes of each group of boxes, which is the same in both operands
+    using Groups = std::map<std::vector<std::string>, std::vector<Box>>;
+
+    const Groups& a() const { return a_; }
+    const Groups& b() const { return b_; }
+
+    std::vector<metkit::mars::MarsRequest> requests(Groups& groups) const {
+        std::vector<metkit::mars::MarsRequest> out;
+        for (auto& g : groups) {
+            const std::vector<std::string>& axes = g.first;
+            merge(g.second, axes.size());
+            for (const Box& b : g.second) {
+                metkit::mars::MarsRequest request(verb_);
+                for (size_t i = 0; i < axes.size(); ++i) {
+                    const std::vector<std::string>& names = values_.at(axes[i]).second;
+                    std::vector<std::string> values;
+                    values.reserve(b[i].size());
+                    for (size_t j : b[i]) {
+                        values.push_back(names[j]);
+                    }
+                    request.values(axes[i], std::move(values));
+                }
+                out.push_back(std::move(request));
             }
         }
-        return p;
+        return out;
     }
-    return idx;
+
+private:
+    void add(const std::vector<metkit::mars::MarsRequest>& requests, Groups& groups) {
+        for (const auto& r : requests) {
+            std::vector<std::string> axes;
+            Box box;
+            for (const auto& name : AxisOrder::instance().axes()) {
+                const metkit::mars::Parameter* p = r.parameter(metkit::mars::Keyword::id(name));
+                if (!p || p->size() == 0) {
+                    continue;
+                }
+                auto& values = values_[name];
+                axes.push_back(name);
+                box.emplace_back();
+                for (const std::string& v : p->values()) {
+                    auto j = values.first.emplace(v, values.second.size());
+                    if (j.second) {
+                        values.second.push_back(v);
+                    }
+                    box.back().push_back(j.first->second);
+                }
+                std::sort(box.back().begin(), box.back().end());
+                box.back().erase(std::unique(box.back().begin(), box.back().end()), box.back().end());
+            }
+            groups[axes].push_back(std::move(box));
+        }
+    }
+
+private:
+    std::string verb_;
+    std::map<std::string, std::pair<std::unordered_map<std::string, size_t>, std::vector<std::string>>> values_;
+    Groups a_;
+    Groups b_;
+};
+
+/// Common fields of two boxes, false if there are none
+bool intersect(const Box& a, const Box& b, Box& out) {
+    out.resize(a.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        out[i].clear();
+        std::set_intersection(a[i].begin(), a[i].end(), b[i].begin(), b[i].end(), std::back_inserter(out[i]));
+        if (out[i].empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Fields of box a not in box b, as at most one disjoint box per axis: the i-th has the values of a not in b on
+/// axis i, those of both before it and those of a after it
+void subtract(const Box& a, const Box& b, std::vector<Box>& out) {
+    Box common;
+    if (!intersect(a, b, common)) {
+        out.push_back(a);
+        return;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        std::vector<size_t> rest;
+        std::set_difference(a[i].begin(), a[i].end(), b[i].begin(), b[i].end(), std::back_inserter(rest));
+        if (!rest.empty()) {
+            Box piece(common.begin(), common.begin() + i);
+            piece.push_back(std::move(rest));
+            piece.insert(piece.end(), a.begin() + i + 1, a.end());
+            out.push_back(std::move(piece));
+        }
+    }
+}
+
+std::vector<Box> subtract(const std::vector<Box>& a, const std::vector<Box>& b) {
+    std::vector<Box> result(a);
+    for (const Box& y : b) {
+        std::vector<Box> next;
+        for (const Box& x : result) {
+            subtract(x, y, next);
+        }
+        result.swap(next);
+    }
+    return result;
+}
+
+/// Makes the boxes disjoint, unless they are known to be
+std::vector<Box> disjoint(const std::vector<Box>& boxes, bool known) {
+    if (known) {
+        return boxes;
+    }
+    std::vector<Box> result;
+    for (const Box& x : boxes) {
+        std::vector<Box> added = subtract(std::vector<Box>{x}, result);
+        result.insert(result.end(), added.begin(), added.end());
+    }
+    return result;
+}
+
+std::vector<metkit::mars::MarsRequest> unite(const std::vector<metkit::mars::MarsRequest>& a, bool disjointA,
+                                             const std::vector<metkit::mars::MarsRequest>& b, bool disjointB) {
+    Operands operands(a, b);
+    Operands::Groups result;
+
+    // a, then what b adds to it
+    for (const auto& g : operands.a()) {
+        result[g.first] = disjoint(g.second, disjointA);
+    }
+    for (const auto& g : operands.b()) {
+        std::vector<Box>& boxes = result[g.first];
+        std::vector<Box> added  = subtract(disjoint(g.second, disjointB), boxes);
+        boxes.insert(boxes.end(), added.begin(), added.end());
+    }
+
+    return operands.requests(result);
+}
+
+std::vector<metkit::mars::MarsRequest> intersect(const std::vector<metkit::mars::MarsRequest>& a, bool disjointA,
+                                                 const std::vector<metkit::mars::MarsRequest>& b, bool disjointB) {
+    Operands operands(a, b);
+    Operands::Groups result;
+
+    for (const auto& g : operands.a()) {
+        auto j = operands.b().find(g.first);
+        if (j == operands.b().end()) {
+            continue;
+        }
+        // Intersections of disjoint boxes are disjoint
+        std::vector<Box> x = disjoint(g.second, disjointA);
+        std::vector<Box> y = disjoint(j->second, disjointB);
+        Box common;
+        for (const Box& u : x) {
+            for (const Box& v : y) {
+                if (intersect(u, v, common)) {
+                    result[g.first].push_back(common);
+                }
+            }
+        }
+    }
+
+    return operands.requests(result);
+}
+
+std::vector<metkit::mars::MarsRequest> subtract(const std::vector<metkit::mars::MarsRequest>& a, bool disjointA,
+                                                const std::vector<metkit::mars::MarsRequest>& b) {
+    Operands operands(a, b);
+    Operands::Groups result;
+
+    for (const auto& g : operands.a()) {
+        auto j = operands.b().find(g.first);
+        result[g.first] =
+            subtract(disjoint(g.second, disjointA), j == operands.b().end() ? std::vector<Box>() : j->second);
+    }
+
+    return operands.requests(result);
+}
+
+}  // namespace
+
+std::vector<metkit::mars::MarsRequest> unite(const std::vector<metkit::mars::MarsRequest>& a,
+                                             const std::vector<metkit::mars::MarsRequest>& b) {
+    return unite(a, a.size() < 2, b, b.size() < 2);
+}
+
+std::vector<metkit::mars::MarsRequest> intersect(const std::vector<metkit::mars::MarsRequest>& a,
+                                                 const std::vector<metkit::mars::MarsRequest>& b) {
+    return intersect(a, a.size() < 2, b, b.size() < 2);
+}
+
+std::vector<metkit::mars::MarsRequest> subtract(const std::vector<metkit::mars::MarsRequest>& a,
+                                                const std::vector<metkit::mars::MarsRequest>& b) {
+    return subtract(a, a.size() < 2, b);
+}
+
+// The vacant requests of a cube are disjoint
+
+std::vector<metkit::mars::MarsRequest> unite(const HyperCube& a, const HyperCube& b) {
+    return unite(a.vacantRequests(), true, b.vacantRequests(), true);
+}
+
+std::vector<metkit::mars::MarsRequest> intersect(const HyperCube& a, const HyperCube& b) {
+    return intersect(a.vacantRequests(), true, b.vacantRequests(), true);
+}
+
+std::vector<metkit::mars::MarsRequest> subtract(const HyperCube& a, const HyperCube& b) {
+    return subtract(a.vacantRequests(), true, b.vacantRequests());
 }
 
 }  // namespace hypercube
@@ -15,14 +15,15 @@
 #ifndef metkit_HyperCube_H
 #define metkit_HyperCube_H
 
+#include <cstddef>
 #include <iosfwd>
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
-#include "eckit/utils/HyperCube.h"
-
 #include "metkit/config/LibMetkit.h"
+#include "metkit/hypercube/Bitmap.h"
 #include "metkit/mars/MarsRequest.h"
 
 
@@ -33,32 +34,57 @@ class Axis;
 
 class HyperCube {
 public:
+    /// Index of a field outside the cube
+    static constexpr size_t npos = size_t(-1);
+
+    /// Throws eckit::UserError if the number of fields does not fit in 64 bits
     HyperCube(const metkit::mars::MarsRequest&);
     ~HyperCube();
 
     bool contains(const metkit::mars::MarsRequest&) const;
     bool clear(const metkit::mars::MarsRequest&);
 
+    /// Indices of many fields, each given as values in the order of names, which must include all the axes of
+    /// the cube; npos for a field outside the cube. Axes are matched to names once for all the fields.
+    std::vector<size_t> indexOf(const std::vector<std::string>& names,
+                                const std::vector<std::vector<std::string>>& fields) const;
+
+    /// As contains() and clear(), for an index returned by indexOf()
+    bool contains(size_t index) const;
+    bool clear(size_t index);
+
     size_t count() const;
     size_t countVacant() const;
-    size_t size() const {return cube_.count(); }
+    size_t size() const { return set_.size(); }
+
+    /// Approximate memory used by the record of vacant fields, in bytes
+    size_t footprint() const { return set_.footprint(); }
 
     size_t fieldOrdinal(const metkit::mars::MarsRequest&, bool noholes = true) const;
+
+    /// Requests for the vacant fields, as disjoint hyper-rectangles of the cube.
+    ///
+    /// With the last axis varying fastest, the vacant fields of each row (one value of every other axis) are read
+    /// from the bitmap, and rows holding the same values of the last axis are grouped. Each group is a set of
+    /// points of the cube of the other axes, decomposed in the same way, and the resulting boxes are extended with
+    /// the group's values. Every level hashes at most V values, V being the number of vacant fields, so with d
+    /// axes and N fields this is O(d.V + N/64), and O(d) for a cube with no holes. Boxes that differ on only one
+    /// axis are then merged, each pass costing O(d.B.a) for B boxes and axes of at most a values.
     std::vector<metkit::mars::MarsRequest> vacantRequests() const;
 
 protected:
-    int indexOf(const metkit::mars::MarsRequest&) const;
-    bool clear(int index);
+    size_t indexOf(const metkit::mars::MarsRequest&) const;
+    void coordinates(size_t index, std::vector<size_t>& coords) const;
     metkit::mars::MarsRequest requestOf(size_t index) const;
-    std::vector<std::pair<metkit::mars::MarsRequest, size_t>> request(std::set<size_t> idxs) const;
 
 private:
     std::string verb_;
     std::vector<Axis*> axes_;
     std::map<std::string, Axis*> axesByName_;
-    std::vector<bool> set_;
-    eckit::HyperCube cube_;
-    size_t count_;
+    Bitmap set_;
+
+    /// Distance between consecutive values of each axis, the last axis varying fastest as in eckit::HyperCube
+    std::vector<size_t> strides_;
 
 
     void print(std::ostream&) const;
@@ -69,6 +95,26 @@ private:
     }
 };
 
+/// Set algebra on the fields of requests, over the axes of axis.yaml. The requests of a list may overlap, and a
+/// field is identified by its values on the axes of its request: fields of requests with different axes are never
+/// the same. A cube stands for its vacant fields.
+///
+/// Each list is turned into boxes of values per axis, without enumerating fields; the boxes of the result are
+/// disjoint, those differing on only one axis are merged, and they are returned as requests holding only the axes,
+/// with the verb of the first request. Between boxes of na and nb requests, intersect() costs O(na.nb.d.a) for d
+/// axes of at most a values, and subtract() splits each box of a in at most d per box of b; two single requests
+/// give a single request or d of them.
+std::vector<metkit::mars::MarsRequest> unite(const std::vector<metkit::mars::MarsRequest>& a,
+                                             const std::vector<metkit::mars::MarsRequest>& b);
+std::vector<metkit::mars::MarsRequest> intersect(const std::vector<metkit::mars::MarsRequest>& a,
+                                                 const std::vector<metkit::mars::MarsRequest>& b);
+std::vector<metkit::mars::MarsRequest> subtract(const std::vector<metkit::mars::MarsRequest>& a,
+                                                const std::vector<metkit::mars::MarsRequest>& b);
+
+std::vector<metkit::mars::MarsRequest> unite(const HyperCube& a, const HyperCube& b);
+std::vector<metkit::mars::MarsRequest> intersect(const HyperCube& a, const HyperCube& b);
+std::vector<metkit::mars::MarsRequest> subtract(const HyperCube& a, const HyperCube& b);
+
 }  // namespace hypercube
 }  // namespace metkit
 
@@ -40,9 +40,9 @@ public:
 
     void add(const metkit::mars::MarsRequest& request, T payload) {
 
-        int idx = indexOf(request);
+        size_t idx = indexOf(request);
 
-        ASSERT(0 <= idx && idx < size());
+        ASSERT(idx != npos && idx < size());
 
         auto entry = entries_.find(idx);
         if (entry == entries_.end()) {
@@ -56,7 +56,6 @@ public:
     }
 
     const T& at(size_t idx) {
-        ASSERT(0 <= idx);
         ASSERT(idx < size());
 
         return entries_[idx];
@@ -0,0 +1,194 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+#include "eckit/config/Resource.h"
+#include "eckit/exception/Exceptions.h"
+#include "eckit/types/Types.h"
+
+#include "metkit/mars/BestMatcher.h"
+#include "metkit/mars/MarsExpandContext.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+std::string lowercase(const std::string& s) {
+    std::string result(s);
+    for (char& c : result) {
+        c = ::tolower(static_cast<unsigned char>(c));
+    }
+    return result;
+}
+
+size_t commonPrefix(const std::string& a, const std::string& b) {
+    size_t len = std::min(a.length(), b.length());
+    size_t s   = 0;
+    while (s < len && a[s] == b[s]) {
+        ++s;
+    }
+    return s;
+}
+
+bool isnumeric(const std::string& s) {
+    for (size_t i = 0; i < s.length(); i++) {
+        if (!::isdigit(s[i])) {
+            return false;
+        }
+    }
+
+    return s.length() > 0;
+}
+
+}  // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+BestMatcher::BestMatcher() {}
+
+BestMatcher::BestMatcher(const std::vector<std::string>& values, const std::map<std::string, std::string>& aliases) :
+    values_(values), aliases_(aliases) {
+    sorted_.reserve(values_.size());
+    exact_.reserve(values_.size());
+    for (size_t i = 0; i < values_.size(); ++i) {
+        sorted_.emplace_back(lowercase(values_[i]), i);
+        exact_.emplace(sorted_.back().first, i);
+    }
+    // Equal keys stay ordered by position, so the first of them is the one a linear scan would find
+    std::sort(sorted_.begin(), sorted_.end());
+}
+
+const std::string& BestMatcher::resolve(const std::string& value) const {
+    auto k = aliases_.find(value);
+    return k == aliases_.end() ? value : (*k).second;
+}
+
+const std::string* BestMatcher::find(const std::string& name) const {
+    auto e = exact_.find(lowercase(name));
+    return e == exact_.end() ? nullptr : &values_[(*e).second];
+}
+
+std::string BestMatcher::match(const MarsExpandContext& ctx, const std::string& name, bool fail, bool quiet) const {
+    static bool strict = eckit::Resource<bool>("$METKIT_LANGUAGE_STRICT_MODE", false);
+
+    std::string key = lowercase(name);
+
+    auto exact = exact_.find(key);
+    if (exact != exact_.end()) {
+        return resolve(values_[(*exact).second]);
+    }
+
+    auto less = [](const std::pair<std::string, size_t>& e, const std::string& k) { return e.first < k; };
+    auto j    = std::lower_bound(sorted_.begin(), sorted_.end(), key, less);
+
+    // The candidates sharing the longest prefix with the input are the neighbours of its insertion point,
+    // and all those sharing that prefix are contiguous
+    size_t score = 0;
+    if (j != sorted_.end()) {
+        score = commonPrefix(key, (*j).first);
+    }
+    if (j != sorted_.begin()) {
+        score = std::max(score, commonPrefix(key, (*(j - 1)).first));
+    }
+
+    std::vector<std::string> best;
+
+    if (score > 0) {
+        std::string prefix = key.substr(0, score);
+        auto hasPrefix     = [&prefix](const std::pair<std::string, size_t>& e) {
+            return e.first.compare(0, prefix.length(), prefix) == 0;
+        };
+
+        auto first = std::lower_bound(sorted_.begin(), sorted_.end(), prefix, less);
+        auto last  = std::partition_point(first, sorted_.end(), hasPrefix);
+
+        std::vector<size_t> positions;
+        positions.reserve(last - first);
+        for (auto k = first; k != last; ++k) {
+            positions.push_back((*k).second);
+        }
+        std::sort(positions.begin(), positions.end());
+
+        best.reserve(positions.size());
+        for (size_t p : positions) {
+            best.push_back(values_[p]);
+        }
+    }
+
+    if (!quiet && best.size() > 0) {
+        std::cerr << "Matching '" << name << "' with " << best << ctx << std::endl;
+    }
+
+    if (best.size() == 1) {
+        if (isnumeric(best[0]) && (best[0] != name)) {
+            best.clear();
+        }
+        else {
+            if (strict) {
+                if (best[0] != name) {
+                    std::ostringstream oss;
+                    oss << "Cannot match [" << name << "] in " << values_ << ctx;
+                    throw eckit::UserError(oss.str());
+                }
+            }
+
+            return resolve(best[0]);
+        }
+    }
+
+    if (best.empty()) {
+        if (!fail) {
+            return std::string();
+        }
+
+        std::ostringstream oss;
+        oss << "Cannot match [" << name << "] in " << values_ << ctx;
+        throw eckit::UserError(oss.str());
+    }
+
+    std::set<std::string> names;
+    for (const std::string& b : best) {
+        names.insert(resolve(b));
+    }
+
+    if (names.size() == 1) {
+        return resolve(best[0]);
+    }
+
+    std::ostringstream oss;
+    oss << "Ambiguous value '" << name << "' could be";
+
+    for (const std::string& b : best) {
+        auto k = aliases_.find(b);
+        if (k == aliases_.end()) {
+            oss << " '" << b << "'";
+        }
+        else {
+            oss << " '" << b << "' (" << (*k).second << ")";
+        }
+    }
+
+    oss << ctx;
+
+    throw eckit::UserError(oss.str());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
@@ -0,0 +1,73 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   BestMatcher.h
+/// @date   Oct 2026
+
+#ifndef metkit_BestMatcher_H
+#define metkit_BestMatcher_H
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace metkit {
+namespace mars {
+
+class MarsExpandContext;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Matches user input against a fixed set of candidates (verbs, keywords, enum values, params), as
+/// MarsLanguage::bestMatch does: an exact case-insensitive match wins, otherwise the candidates sharing the
+/// longest case-insensitive prefix with the input are retained, and must be unique or aliases of one value.
+///
+/// The candidates are lowercased and hashed once for exact matches, and sorted for abbreviations, so that a
+/// lookup is a hash probe or a binary search rather than a scan of the whole vocabulary. Candidates keep
+/// their original order in messages.
+
+class BestMatcher {
+public:  // methods
+    BestMatcher();
+    BestMatcher(const std::vector<std::string>& values,
+                const std::map<std::string, std::string>& aliases = std::map<std::string, std::string>());
+
+    /// Returns the matched value (or the value it is an alias of), or an empty string if there is none
+    /// and fail is false. Throws on ambiguous input.
+    std::string match(const MarsExpandContext& ctx, const std::string& name, bool fail, bool quiet) const;
+
+    /// First candidate equal to name, ignoring case, or null
+    const std::string* find(const std::string& name) const;
+
+    const std::vector<std::string>& values() const { return values_; }
+
+private:  // methods
+    const std::string& resolve(const std::string& value) const;
+
+private:  // members
+    /// Candidates, in their original order
+    std::vector<std::string> values_;
+    std::map<std::string, std::string> aliases_;
+
+    /// Lowercased candidates with their position in values_, sorted
+    std::vector<std::pair<std::string, size_t>> sorted_;
+
+    /// Lowercased candidates to the position of the first one in values_
+    std::unordered_map<std::string, size_t> exact_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
@@ -0,0 +1,54 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   BitCount.h
+/// @date   Oct 2026
+
+#ifndef metkit_BitCount_H
+#define metkit_BitCount_H
+
+#include <cstdint>
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Bit counting on 64-bit words, for Bitset and hypercube::Bitmap.
+/// With GCC and Clang these are compiler builtins. On x86-64 the builtin popcount is a library call
+/// unless the popcnt instruction is enabled, which the POPCNT build option does (-mpopcnt).
+
+/// Number of set bits in w
+inline unsigned popcount(uint64_t w) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(w);
+#else
+    w = w - ((w >> 1) & 0x5555555555555555ULL);
+    w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+    w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return unsigned((w * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/// Index of the lowest set bit in w, which must not be zero
+inline unsigned countTrailingZeros(uint64_t w) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(w);
+#else
+    return popcount((w & (~w + 1)) - 1);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
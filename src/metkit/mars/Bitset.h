@@ -0,0 +1,161 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   Bitset.h
+/// @date   Oct 2026
+
+#ifndef metkit_Bitset_H
+#define metkit_Bitset_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "metkit/mars/BitCount.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Dynamically sized bitset, stored as 64-bit words.
+/// Bits past size() are always kept clear, so words can be combined and counted directly.
+
+class Bitset {
+public:  // methods
+    Bitset() : size_(0) {}
+    explicit Bitset(size_t size, bool value = false) : size_(0) { resize(size, value); }
+
+    size_t size() const { return size_; }
+
+    /// Resizes the bitset, new bits being set to value
+    void resize(size_t size, bool value = false) {
+        size_t old = size_;
+        words_.resize((size + 63) / 64, 0);
+        size_ = size;
+        if (value) {
+            for (size_t i = old; i < size && (i & 63); ++i) {
+                set(i);
+            }
+            for (size_t w = (old + 63) / 64; w < words_.size(); ++w) {
+                words_[w] = ~uint64_t(0);
+            }
+        }
+        trim();
+    }
+
+    bool test(size_t i) const {
+        ASSERT(i < size_);
+        return (words_[i >> 6] >> (i & 63)) & 1;
+    }
+
+    void set(size_t i) {
+        ASSERT(i < size_);
+        words_[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+
+    void reset(size_t i) {
+        ASSERT(i < size_);
+        words_[i >> 6] &= ~(uint64_t(1) << (i & 63));
+    }
+
+    /// Sets all bits
+    void set() {
+        for (auto& w : words_) {
+            w = ~uint64_t(0);
+        }
+        trim();
+    }
+
+    /// Clears all bits
+    void reset() {
+        for (auto& w : words_) {
+            w = 0;
+        }
+    }
+
+    size_t count() const {
+        size_t n = 0;
+        for (auto w : words_) {
+            n += popcount(w);
+        }
+        return n;
+    }
+
+    bool any() const {
+        for (auto w : words_) {
+            if (w) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool none() const { return !any(); }
+
+    /// Index of the first set bit at or after i, or size() if there is none
+    size_t next(size_t i) const {
+        if (i >= size_) {
+            return size_;
+        }
+        size_t w   = i >> 6;
+        uint64_t v = words_[w] & (~uint64_t(0) << (i & 63));
+        while (!v) {
+            if (++w == words_.size()) {
+                return size_;
+            }
+            v = words_[w];
+        }
+        return (w << 6) + countTrailingZeros(v);
+    }
+
+    Bitset& operator&=(const Bitset& other) {
+        ASSERT(size_ == other.size_);
+        for (size_t w = 0; w < words_.size(); ++w) {
+            words_[w] &= other.words_[w];
+        }
+        return *this;
+    }
+
+    Bitset& operator|=(const Bitset& other) {
+        ASSERT(size_ == other.size_);
+        for (size_t w = 0; w < words_.size(); ++w) {
+            words_[w] |= other.words_[w];
+        }
+        return *this;
+    }
+
+    bool operator==(const Bitset& other) const { return size_ == other.size_ && words_ == other.words_; }
+    bool operator!=(const Bitset& other) const { return !(*this == other); }
+
+    /// Raw words, least significant bit first
+    const std::vector<uint64_t>& words() const { return words_; }
+    std::vector<uint64_t>& words() { return words_; }
+
+    /// Clears the bits of the last word that are past size(), after direct updates of words()
+    void trim() {
+        if (size_ & 63) {
+            words_.back() &= (uint64_t(1) << (size_ & 63)) - 1;
+        }
+    }
+
+private:  // members
+    std::vector<uint64_t> words_;
+    size_t size_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
@@ -0,0 +1,181 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <ostream>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "metkit/mars/CompiledMarsFilter.h"
+#include "metkit/mars/Keyword.h"
+#include "metkit/mars/MarsRequest.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+CompiledMarsFilter::CompiledMarsFilter() : size_(0), capacity_(0) {}
+
+CompiledMarsFilter::CompiledMarsFilter(const MarsRequest& filter) : size_(0), capacity_(0) {
+    add(filter);
+}
+
+CompiledMarsFilter::CompiledMarsFilter(const std::vector<MarsRequest>& filters) : size_(0), capacity_(0) {
+    reserve(filters.size());
+    for (const auto& filter : filters) {
+        add(filter);
+    }
+}
+
+void CompiledMarsFilter::reserve(size_t n) {
+    if (n <= capacity_) {
+        return;
+    }
+    capacity_ = n;
+    for (auto& slot : slots_) {
+        slot.constrained.resize(capacity_);
+        for (auto& a : slot.accepted) {
+            a.second.resize(capacity_);
+        }
+    }
+}
+
+size_t CompiledMarsFilter::add(const MarsRequest& filter) {
+    size_t n = size_++;
+    if (size_ > capacity_) {
+        reserve(std::max<size_t>(64, 2 * capacity_));
+    }
+
+    // Values are only compared as strings (see the class comment), Type::matches() is not used
+    for (const std::string& name : filter.params()) {
+        size_t id = Keyword::id(name);
+
+        if (index_.size() <= id) {
+            index_.resize(id + 1, 0);
+        }
+
+        if (!index_[id]) {
+            slots_.push_back(Slot{id, Bitset(capacity_), {}});
+            index_[id] = slots_.size();
+        }
+
+        Slot& slot = slots_[index_[id] - 1];
+        if (slot.constrained.test(n)) {
+            // Repeated keyword: like MarsRequest::matches, only the first one counts
+            continue;
+        }
+        slot.constrained.set(n);
+
+        for (const std::string& value : filter.values(name)) {
+            auto a = slot.accepted.find(value);
+            if (a == slot.accepted.end()) {
+                a = slot.accepted.emplace(value, Bitset(capacity_)).first;
+            }
+            a->second.set(n);
+        }
+    }
+
+    return n;
+}
+
+bool CompiledMarsFilter::matches(const MarsRequest& request, size_t i) const {
+    ASSERT(i < size_);
+
+    for (const auto& slot : slots_) {
+        if (!slot.constrained.test(i)) {
+            continue;
+        }
+
+        const Parameter* p = request.parameter(slot.keyword);
+        if (!p) {
+            return false;
+        }
+
+        bool found = false;
+        for (const std::string& value : p->values()) {
+            auto a = slot.accepted.find(value);
+            if (a != slot.accepted.end() && a->second.test(i)) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void CompiledMarsFilter::matches(const MarsRequest& request, Bitset& result) const {
+    Bitset scratch;
+    matches(request, result, scratch);
+}
+
+void CompiledMarsFilter::matches(const std::vector<MarsRequest>& requests, std::vector<Bitset>& results) const {
+    Bitset scratch;
+    results.resize(requests.size());
+    for (size_t j = 0; j < requests.size(); ++j) {
+        matches(requests[j], results[j], scratch);
+    }
+}
+
+void CompiledMarsFilter::matches(const MarsRequest& request, Bitset& result, Bitset& scratch) const {
+    result.resize(size_);
+    result.set();
+    scratch.resize(size_);
+
+    std::vector<uint64_t>& r       = result.words();
+    std::vector<uint64_t>& allowed = scratch.words();
+
+    for (const auto& slot : slots_) {
+        // Filters that do not constrain the keyword let the request through...
+        const std::vector<uint64_t>& constrained = slot.constrained.words();
+        for (size_t w = 0; w < allowed.size(); ++w) {
+            allowed[w] = ~constrained[w];
+        }
+
+        // ... as do those accepting one of its values
+        if (const Parameter* p = request.parameter(slot.keyword)) {
+            for (const std::string& value : p->values()) {
+                auto a = slot.accepted.find(value);
+                if (a != slot.accepted.end()) {
+                    const std::vector<uint64_t>& accepted = a->second.words();
+                    for (size_t w = 0; w < allowed.size(); ++w) {
+                        allowed[w] |= accepted[w];
+                    }
+                }
+            }
+        }
+
+        bool any = false;
+        for (size_t w = 0; w < r.size(); ++w) {
+            r[w] &= allowed[w];
+            any |= r[w] != 0;
+        }
+
+        if (!any) {
+            break;
+        }
+    }
+
+    result.trim();
+}
+
+void CompiledMarsFilter::print(std::ostream& out) const {
+    out << "CompiledMarsFilter[filters=" << size_ << ",keywords=" << slots_.size() << "]";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
@@ -0,0 +1,108 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   CompiledMarsFilter.h
+/// @date   Oct 2026
+
+#ifndef metkit_CompiledMarsFilter_H
+#define metkit_CompiledMarsFilter_H
+
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "metkit/mars/Bitset.h"
+
+namespace metkit {
+namespace mars {
+
+class MarsRequest;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// A set of filter requests (e.g. subscriptions), compiled once for repeated matching.
+///
+/// A request matches filter i exactly when request.matches(filter i) would be true: for every keyword of the
+/// filter, the request has that keyword with at least one of the filter's values.
+///
+/// Keywords are resolved to slots and, for each slot, every value maps to the bitset of filters accepting it,
+/// so matching a request against all filters costs one hash lookup per request value plus a few word
+/// operations per slot, whatever the number of filters.
+///
+/// Values are compared as plain strings, as MarsRequest::matches does: the keyword types, and their matches(),
+/// are not consulted, so filters and requests should be expanded (or written) the same way.
+///
+/// The bitsets of the slots are sized for a capacity of filters, doubled when full, so that adding N filters
+/// costs O(N) resizes of each bitset in total rather than one each.
+
+class CompiledMarsFilter {
+public:  // methods
+    CompiledMarsFilter();
+    explicit CompiledMarsFilter(const MarsRequest& filter);
+    explicit CompiledMarsFilter(const std::vector<MarsRequest>& filters);
+
+    /// Adds a filter, returning its index
+    size_t add(const MarsRequest& filter);
+
+    /// Number of filters
+    size_t size() const { return size_; }
+
+    /// Whether the request matches filter i
+    bool matches(const MarsRequest&, size_t i = 0) const;
+
+    /// Sets bit i of result for each filter i matched by the request
+    void matches(const MarsRequest&, Bitset& result) const;
+
+    /// Batch evaluation, results[j] being the filters matched by requests[j]
+    void matches(const std::vector<MarsRequest>& requests, std::vector<Bitset>& results) const;
+
+private:  // types
+    struct Slot {
+        size_t keyword;
+
+        /// Filters that constrain this keyword
+        Bitset constrained;
+
+        /// For each value, the filters accepting it
+        std::unordered_map<std::string, Bitset> accepted;
+    };
+
+private:  // methods
+    /// Makes room for n filters in the bitsets of every slot
+    void reserve(size_t n);
+
+    void print(std::ostream&) const;
+
+    void matches(const MarsRequest&, Bitset& result, Bitset& scratch) const;
+
+    friend std::ostream& operator<<(std::ostream& s, const CompiledMarsFilter& f) {
+        f.print(s);
+        return s;
+    }
+
+private:  // members
+    std::vector<Slot> slots_;
+
+    /// Slot + 1 of each keyword id, 0 when no filter uses it
+    std::vector<size_t> index_;
+
+    size_t size_;
+
+    /// Size of the bitsets of the slots, at least size_
+    size_t capacity_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
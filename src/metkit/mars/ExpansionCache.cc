@@ -0,0 +1,174 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <functional>
+#include <ostream>
+
+#include "eckit/config/Resource.h"
+#include "eckit/types/Date.h"
+
+#include "metkit/mars/ExpansionCache.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+double ExpansionCache::Metrics::hitRate() const {
+    size_t lookups = hits + misses;
+    return lookups ? double(hits) / lookups : 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ExpansionCache::ExpansionCache() :
+    capacity_(eckit::Resource<long>("metkitExpansionCacheSize;$METKIT_EXPANSION_CACHE_SIZE", 0)) {}
+
+ExpansionCache& ExpansionCache::instance() {
+    static ExpansionCache cache;
+    return cache;
+}
+
+long ExpansionCache::today() const {
+    // As TypeDate::expand() turns relative dates into dates
+    return clock_ ? clock_() : eckit::Date(0).julian();
+}
+
+uint64_t ExpansionCache::key(const MarsLanguage& language, const MarsRequest& request, bool inherit, bool strict,
+                             const ExpansionSession& session, long day) {
+    uint64_t h  = request.hash();
+    auto combine = [&h](uint64_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+
+    combine(std::hash<const MarsLanguage*>()(&language));
+    combine(inherit ? session.hash() : 0);
+    combine((inherit ? 2 : 0) + (strict ? 1 : 0));
+    combine(uint64_t(day));
+    return h;
+}
+
+bool ExpansionCache::lookup(const MarsLanguage& language, const MarsRequest& request, bool inherit, bool strict,
+                            ExpansionSession& session, MarsRequest& result) {
+    if (!enabled()) {
+        return false;
+    }
+
+    long day   = today();
+    uint64_t k = key(language, request, inherit, strict, session, day);
+
+    std::shared_ptr<const Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto j = index_.find(k);
+        if (j != index_.end()) {
+            order_.splice(order_.begin(), order_, j->second);
+            entry = j->second->second;
+        }
+    }
+
+    // Keys are hashes: the entry is only a hit if it was made from the same input
+    if (!entry || entry->language != &language || entry->day != day || entry->inherit != inherit ||
+        entry->strict != strict || !(entry->request == request) || (inherit && !(entry->before == session))) {
+        misses_++;
+        return false;
+    }
+
+    hits_++;
+    result = entry->result;
+    if (inherit) {
+        session = entry->after;
+    }
+    return true;
+}
+
+void ExpansionCache::insert(const MarsLanguage& language, const MarsRequest& request, bool inherit, bool strict,
+                            const ExpansionSession& before, const ExpansionSession& after,
+                            const MarsRequest& result) {
+    if (!enabled()) {
+        return;
+    }
+
+    long day   = today();
+    uint64_t k = key(language, request, inherit, strict, before, day);
+
+    std::shared_ptr<const Entry> entry(new Entry{&language, day, request, inherit, strict,
+                                                 inherit ? before : ExpansionSession(),
+                                                 inherit ? after : ExpansionSession(), result});
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // A colliding entry is replaced
+    auto j = index_.find(k);
+    if (j != index_.end()) {
+        order_.erase(j->second);
+        index_.erase(j);
+    }
+
+    order_.emplace_front(k, entry);
+    index_[k] = order_.begin();
+    insertions_++;
+
+    trim();
+}
+
+void ExpansionCache::trim() {
+    size_t capacity = capacity_.load(std::memory_order_relaxed);
+    while (order_.size() > capacity) {
+        index_.erase(order_.back().first);
+        order_.pop_back();
+        evictions_++;
+    }
+}
+
+void ExpansionCache::capacity(size_t n) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_.store(n, std::memory_order_relaxed);
+    trim();
+}
+
+void ExpansionCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    order_.clear();
+    index_.clear();
+}
+
+void ExpansionCache::clock(std::function<long()> clock) {
+    clock_ = std::move(clock);
+}
+
+ExpansionCache::Metrics ExpansionCache::metrics() const {
+    Metrics m;
+    m.hits       = hits_;
+    m.misses     = misses_;
+    m.insertions = insertions_;
+    m.evictions  = evictions_;
+    m.capacity   = capacity_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    m.size = order_.size();
+    return m;
+}
+
+void ExpansionCache::resetMetrics() {
+    hits_       = 0;
+    misses_     = 0;
+    insertions_ = 0;
+    evictions_  = 0;
+}
+
+void ExpansionCache::print(std::ostream& out) const {
+    Metrics m = metrics();
+    out << "ExpansionCache[size=" << m.size << ",capacity=" << m.capacity << ",hits=" << m.hits
+        << ",misses=" << m.misses << ",hitRate=" << m.hitRate() << ",evictions=" << m.evictions << "]";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
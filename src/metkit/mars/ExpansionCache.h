@@ -0,0 +1,152 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   ExpansionCache.h
+/// @date   Oct 2026
+
+#ifndef metkit_ExpansionCache_H
+#define metkit_ExpansionCache_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "eckit/memory/NonCopyable.h"
+
+#include "metkit/mars/ExpansionSession.h"
+#include "metkit/mars/MarsRequest.h"
+
+namespace metkit {
+namespace mars {
+
+class MarsLanguage;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Process-wide cache of expanded requests, used by MarsExpension so that a request seen before is not expanded
+/// again. It is keyed by the language (hence the verb), the request as given, the strict flag, the current day
+/// and, when inheriting, the values inherited from the previous requests. With inheritance, a hit also gives the
+/// session the state the expansion would have left it in.
+///
+/// The cache is off unless given a capacity, in requests, with capacity() or METKIT_EXPANSION_CACHE_SIZE; the
+/// least recently used entries are dropped beyond it. Warnings the expansion would print are not repeated on
+/// a hit.
+///
+/// Entries are only valid for the language they were made with. Languages are read once per process and never
+/// reloaded, so a change to the language (or param) files is seen by restarting, as for expansion itself; a
+/// program building its own languages must clear() the cache.
+///
+/// Expansion also depends on the clock: relative dates, such as date=0 (the default) or date=-1, become dates
+/// relative to today. Entries are therefore only valid on the day they were made, and after midnight every
+/// request misses once; the entries of previous days are left for the least recently used to drop.
+
+class ExpansionCache : private eckit::NonCopyable {
+public:  // types
+    struct Metrics {
+        size_t hits       = 0;
+        size_t misses     = 0;
+        size_t insertions = 0;
+        size_t evictions  = 0;
+        size_t size       = 0;
+        size_t capacity   = 0;
+
+        /// Fraction of lookups that were hits, 0 if there were none
+        double hitRate() const;
+    };
+
+public:  // methods
+    static ExpansionCache& instance();
+
+    bool enabled() const { return capacity_.load(std::memory_order_relaxed) > 0; }
+
+    size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+
+    /// Sets the maximum number of entries, dropping the oldest ones beyond it; 0 turns the cache off
+    void capacity(size_t);
+
+    /// On a hit, sets the expanded request and, when inheriting, the state of the session
+    bool lookup(const MarsLanguage& language, const MarsRequest& request, bool inherit, bool strict,
+                ExpansionSession& session, MarsRequest& result);
+
+    /// Records an expansion, given the session before and after it (ignored without inheritance)
+    void insert(const MarsLanguage& language, const MarsRequest& request, bool inherit, bool strict,
+                const ExpansionSession& before, const ExpansionSession& after, const MarsRequest& result);
+
+    /// Drops all the entries; the metrics are kept
+    void clear();
+
+    /// Replaces the clock giving the current day, as a Julian day number, for testing; an empty function restores
+    /// the system clock. Not to be called while requests are being expanded.
+    void clock(std::function<long()>);
+
+    Metrics metrics() const;
+
+    void resetMetrics();
+
+private:  // types
+    struct Entry {
+        const MarsLanguage* language;
+        long day;
+        MarsRequest request;
+        bool inherit;
+        bool strict;
+        ExpansionSession before;
+        ExpansionSession after;
+        MarsRequest result;
+    };
+
+    typedef std::list<std::pair<uint64_t, std::shared_ptr<const Entry>>> Order;
+
+private:  // methods
+    ExpansionCache();
+
+    static uint64_t key(const MarsLanguage& language, const MarsRequest& request, bool inherit, bool strict,
+                        const ExpansionSession& session, long day);
+
+    long today() const;
+
+    /// Drops the least recently used entries beyond the capacity; the mutex must be held
+    void trim();
+
+    void print(std::ostream&) const;
+
+    friend std::ostream& operator<<(std::ostream& s, const ExpansionCache& c) {
+        c.print(s);
+        return s;
+    }
+
+private:  // members
+    mutable std::mutex mutex_;
+
+    /// Most recently used first
+    Order order_;
+    std::unordered_map<uint64_t, Order::iterator> index_;
+
+    std::atomic<size_t> capacity_;
+
+    std::function<long()> clock_;
+
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+    std::atomic<size_t> insertions_{0};
+    std::atomic<size_t> evictions_{0};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <functional>
+
+#include "metkit/mars/ExpansionSession.h"
+#include "metkit/mars/Type.h"
+#include "metkit/mars/ValueRange.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const std::vector<std::string>& ExpansionSession::defaults(const Type& type) const {
+    auto j = defaults_.find(&type);
+    if (j == defaults_.end()) {
+        return type.defaults();
+    }
+    return j->second.values();
+}
+
+const Parameter* ExpansionSession::inherited(const Type& type) const {
+    auto j = defaults_.find(&type);
+    return j == defaults_.end() ? nullptr : &j->second;
+}
+
+void ExpansionSession::setDefaults(const Type& type, const std::vector<std::string>& defaults) {
+    hash_ = 0;
+    defaults_[&type] = Parameter(defaults, &type);
+}
+
+void ExpansionSession::setDefaults(const Type& type, const Parameter& p) {
+    hash_ = 0;
+    defaults_[&type] = p;
+}
+
+void ExpansionSession::clearDefaults(const Type& type) {
+    hash_ = 0;
+    defaults_[&type] = Parameter(std::vector<std::string>(), &type);
+}
+
+void ExpansionSession::reset() {
+    hash_ = 0;
+    defaults_.clear();
+}
+
+uint64_t ExpansionSession::hash() const {
+    if (hash_) {
+        return hash_;
+    }
+
+    std::hash<std::string> hasher;
+    auto combine = [](uint64_t& h, uint64_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+
+    // Entries are summed, as the map has no order; ranges are hashed without making their values
+    uint64_t h = 0;
+    for (const auto& d : defaults_) {
+        uint64_t e = std::hash<const Type*>()(d.first);
+        if (const ValueRange* range = d.second.range()) {
+            combine(e, range->hash());
+        }
+        else {
+            const std::vector<std::string>& values = d.second.values();
+            combine(e, values.size());
+            for (const std::string& s : values) {
+                combine(e, hasher(s));
+            }
+        }
+        h += e;
+    }
+
+    hash_ = h ? h : 1;
+    return hash_;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
@@ -0,0 +1,68 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   ExpansionSession.h
+/// @date   Oct 2026
+
+#ifndef metkit_ExpansionSession_H
+#define metkit_ExpansionSession_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "metkit/mars/Parameter.h"
+
+namespace metkit {
+namespace mars {
+
+class Type;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Inheritance state of a sequence of expansions: the defaults each request passes on to the following ones.
+///
+/// Languages and their types are immutable once built and can be shared between threads; everything that
+/// changes from one request to the next lives here, so each thread (or client) expands with its own session.
+
+class ExpansionSession {
+public:  // methods
+    /// Current defaults of a type, initially those of its definition
+    const std::vector<std::string>& defaults(const Type&) const;
+
+    /// Values passed on by a previous request, possibly a symbolic range, or null if there were none
+    const Parameter* inherited(const Type&) const;
+
+    void setDefaults(const Type&, const std::vector<std::string>& defaults);
+    void setDefaults(const Type&, const Parameter&);
+    void clearDefaults(const Type&);
+
+    /// Back to the defaults of the definitions
+    void reset();
+
+    /// Hash of the inherited values, independent of the order they were set in; used to key ExpansionCache
+    uint64_t hash() const;
+
+    bool operator==(const ExpansionSession& other) const { return defaults_ == other.defaults_; }
+
+private:  // members
+    std::unordered_map<const Type*, Parameter> defaults_;
+
+    /// Cached result of hash(), 0 when not computed
+    mutable uint64_t hash_ = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
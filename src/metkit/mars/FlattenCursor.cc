@@ -0,0 +1,194 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <algorithm>
+#include <ostream>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "metkit/mars/FlattenCursor.h"
+#include "metkit/mars/MarsLanguage.h"
+#include "metkit/mars/Type.h"
+#include "metkit/mars/ValueRange.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t FlattenCursor::Field::ordinal() const {
+    return cursor_.position_;
+}
+
+size_t FlattenCursor::Field::size() const {
+    return cursor_.state_->axes.size();
+}
+
+const std::string& FlattenCursor::Field::keyword(size_t i) const {
+    return cursor_.state_->axes[i].keyword;
+}
+
+const std::string& FlattenCursor::Field::value(size_t i) const {
+    const Axis& axis = cursor_.state_->axes[i];
+    return axis.list ? (*axis.list)[cursor_.indices_[i]] : cursor_.values_[i];
+}
+
+const std::string& FlattenCursor::Field::operator[](const std::string& keyword) const {
+    const std::vector<Axis>& axes = cursor_.state_->axes;
+    for (size_t i = 0; i < axes.size(); ++i) {
+        if (axes[i].keyword == keyword) {
+            return value(i);
+        }
+    }
+    return cursor_.state_->request[keyword];
+}
+
+MarsRequest FlattenCursor::Field::request() const {
+    MarsRequest result(cursor_.state_->request);
+    for (size_t i = 0; i < size(); ++i) {
+        result.setValue(keyword(i), value(i));
+    }
+    return result;
+}
+
+void FlattenCursor::Field::print(std::ostream& out) const {
+    const char* sep = "";
+    for (size_t i = 0; i < size(); ++i) {
+        out << sep << keyword(i) << "=" << value(i);
+        sep = ",";
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FlattenCursor::FlattenCursor(const MarsLanguage& language, const MarsRequest& request) {
+    std::shared_ptr<State> state(new State{request, {}, 1});
+
+    std::vector<std::string> params;
+    state->request.getParams(params);
+
+    for (const std::string& name : params) {
+        const Type* t = language.type(name);
+        if (!t->flatten()) {
+            continue;
+        }
+
+        const Parameter* p = state->request.parameter(t->keyword());
+        if (p && p->range()) {
+            state->axes.push_back(Axis{name, nullptr, p->range(), p->range()->size()});
+        }
+        else {
+            const std::vector<std::string>& values = t->flattenValues(state->request);
+            state->axes.push_back(Axis{name, &values, nullptr, values.size()});
+        }
+        state->size *= state->axes.back().size;
+    }
+
+    state_    = state;
+    indices_  = std::vector<size_t>(state_->axes.size(), 0);
+    values_   = std::vector<std::string>(state_->axes.size());
+    position_ = 0;
+    end_      = state_->size;
+    start();
+}
+
+FlattenCursor::FlattenCursor(const std::shared_ptr<const State>& state, size_t begin, size_t end) :
+    state_(state),
+    indices_(state->axes.size(), 0),
+    values_(state->axes.size()),
+    position_(begin),
+    end_(end) {
+    start();
+}
+
+size_t FlattenCursor::size() const {
+    return state_->size;
+}
+
+void FlattenCursor::load(size_t axis) {
+    const Axis& a = state_->axes[axis];
+    if (a.range) {
+        values_[axis] = (*a.range)[indices_[axis]];
+    }
+}
+
+void FlattenCursor::start() {
+    for (size_t i = 0; i < indices_.size(); ++i) {
+        load(i);
+    }
+    locate();
+    changed_ = 0;
+}
+
+void FlattenCursor::locate() {
+    changed_ = indices_.size();
+    if (done()) {
+        return;
+    }
+
+    size_t n = position_;
+    for (size_t i = indices_.size(); i-- > 0;) {
+        const size_t size = state_->axes[i].size;
+        const size_t index = n % size;
+        n /= size;
+        if (index != indices_[i]) {
+            indices_[i] = index;
+            load(i);
+            changed_ = i;
+        }
+    }
+}
+
+void FlattenCursor::next() {
+    ++position_;
+    if (done()) {
+        return;
+    }
+
+    // Not past the last field, so the first index never wraps
+    size_t i = indices_.size() - 1;
+    while (++indices_[i] == state_->axes[i].size) {
+        indices_[i] = 0;
+        load(i);
+        --i;
+    }
+    load(i);
+    changed_ = i;
+}
+
+void FlattenCursor::skip(size_t n) {
+    seek(n < end_ - position_ ? position_ + n : end_);
+}
+
+void FlattenCursor::seek(size_t ordinal) {
+    ASSERT(ordinal >= position_);
+    position_ = std::min(ordinal, end_);
+    locate();
+}
+
+std::vector<FlattenCursor> FlattenCursor::split(size_t n) const {
+    std::vector<FlattenCursor> chunks;
+    if (done() || n == 0) {
+        return chunks;
+    }
+
+    const size_t left = end_ - position_;
+    n                 = std::min(n, left);
+
+    for (size_t i = 0; i < n; ++i) {
+        chunks.push_back(FlattenCursor(state_, position_ + i * left / n, position_ + (i + 1) * left / n));
+    }
+    return chunks;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
@@ -0,0 +1,155 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   FlattenCursor.h
+/// @date   Oct 2026
+
+#ifndef metkit_FlattenCursor_H
+#define metkit_FlattenCursor_H
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "metkit/mars/MarsRequest.h"
+
+namespace metkit {
+namespace mars {
+
+class MarsLanguage;
+class ValueRange;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Walks the fields of a request, i.e. the Cartesian product of the values of its flattened keywords, in the
+/// order of MarsLanguage::flatten(): the last keyword varies fastest.
+///
+/// The position is a tuple of indices, one per flattened keyword, moved on like an odometer, and the field
+/// under the cursor is a view of it: no MarsRequest is made unless Field::request() is called. Ranges are
+/// read from their progression (see ValueRange), without materialising their list.
+///
+/// A cursor can jump ahead with skip() or seek(), and split() cuts the fields left into contiguous cursors
+/// that can be moved on by different threads. They share the request and its values, which are read-only.
+
+class FlattenCursor {
+public:  // types
+    /// The field under a cursor, valid until the cursor moves
+    class Field {
+    public:
+        /// Position of the field amongst all those of the request
+        size_t ordinal() const;
+
+        /// Number of flattened keywords
+        size_t size() const;
+
+        const std::string& keyword(size_t i) const;
+        const std::string& value(size_t i) const;
+
+        /// Value of a flattened keyword, or the single value of another keyword of the request
+        const std::string& operator[](const std::string& keyword) const;
+
+        /// The request with one value for each flattened keyword, as given to a FlattenCallback
+        MarsRequest request() const;
+
+    private:
+        explicit Field(const FlattenCursor& cursor) : cursor_(cursor) {}
+
+        const FlattenCursor& cursor_;
+
+        friend class FlattenCursor;
+
+        friend std::ostream& operator<<(std::ostream& s, const Field& f) {
+            f.print(s);
+            return s;
+        }
+
+        void print(std::ostream&) const;
+    };
+
+public:  // methods
+    FlattenCursor(const MarsLanguage& language, const MarsRequest& request);
+
+    /// Number of fields of the whole request
+    size_t size() const;
+
+    /// Ordinal of the field under the cursor
+    size_t position() const { return position_; }
+
+    /// Ordinal after the last field this cursor walks
+    size_t end() const { return end_; }
+
+    bool done() const { return position_ >= end_; }
+
+    Field field() const { return Field(*this); }
+    Field operator*() const { return field(); }
+
+    /// Moves on to the next field
+    void next();
+
+    /// Moves n fields on, stopping at end()
+    void skip(size_t n);
+
+    /// Moves to the field of the given ordinal, which must not be before position()
+    void seek(size_t ordinal);
+
+    /// First flattened keyword whose value changed with the last move: those before it kept theirs
+    size_t changed() const { return changed_; }
+
+    /// Cuts the fields left into at most n contiguous cursors of (nearly) equal size, in order
+    std::vector<FlattenCursor> split(size_t n) const;
+
+private:  // types
+    struct Axis {
+        std::string keyword;
+        /// Either the list of the values, or their range
+        const std::vector<std::string>* list;
+        const ValueRange* range;
+        size_t size;
+    };
+
+    /// What the cursors cut from the same one share
+    struct State {
+        MarsRequest request;
+        std::vector<Axis> axes;
+        size_t size;
+    };
+
+private:  // methods
+    FlattenCursor(const std::shared_ptr<const State>& state, size_t begin, size_t end);
+
+    /// Makes the values of all the axes, then moves to position_
+    void start();
+
+    /// Sets the indices from position_, and the values of the axes that changed
+    void locate();
+
+    /// Makes the value of an axis that is a range
+    void load(size_t axis);
+
+private:  // members
+    std::shared_ptr<const State> state_;
+
+    std::vector<size_t> indices_;
+
+    /// Values of the axes that are ranges, made as the cursor moves
+    std::vector<std::string> values_;
+
+    size_t position_;
+    size_t end_;
+    size_t changed_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include "metkit/mars/Keyword.h"
+#include "metkit/mars/StringPool.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr size_t Keyword::npos;
+
+size_t Keyword::id(const std::string& name) {
+    return StringPool::keywords().intern(name).id();
+}
+
+size_t Keyword::lookup(const std::string& name) {
+    const StringPool::Entry* e = StringPool::keywords().find(name);
+    return e ? e->id() : npos;
+}
+
+size_t Keyword::size() {
+    return StringPool::keywords().size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
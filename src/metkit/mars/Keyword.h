@@ -0,0 +1,49 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   Keyword.h
+/// @date   Oct 2026
+
+#ifndef metkit_Keyword_H
+#define metkit_Keyword_H
+
+#include <cstddef>
+#include <string>
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Process-wide registry giving every keyword name a small, dense integer id.
+/// Ids are never recycled, so they can be used to index per-request tables.
+/// Names are held in StringPool::keywords().
+
+class Keyword {
+public:  // types
+    static constexpr size_t npos = size_t(-1);
+
+public:  // class methods
+    /// Returns the id of the keyword, registering it if needed
+    static size_t id(const std::string& name);
+
+    /// Returns the id of the keyword, or npos if it was never registered
+    static size_t lookup(const std::string& name);
+
+    /// Number of keywords registered so far
+    static size_t size();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
@@ -20,6 +20,7 @@
 #include "eckit/utils/MD5.h"
 #include "eckit/utils/StringTools.h"
 
+#include "metkit/mars/ExpansionCache.h"
 #include "metkit/mars/MarsExpension.h"
 #include "metkit/mars/Type.h"
 #include "metkit/mars/MarsLanguage.h"
@@ -42,27 +43,20 @@ MarsExpension::MarsExpension(bool inherit, bool strict):
 
 }
 
-MarsExpension::~MarsExpension() {
-    for (std::map<std::string, MarsLanguage* >::iterator j = languages_.begin(); j != languages_.end(); ++j) {
-        delete (*j).second;
-    }
-}
+MarsExpension::~MarsExpension() {}
 
 void MarsExpension::reset() {
-    for (std::map<std::string, MarsLanguage* >::iterator j = languages_.begin(); j != languages_.end(); ++j) {
-        (*j).second->reset();
-    }
+    session_.reset();
 }
 
 
-MarsLanguage& MarsExpension::language(const MarsExpandContext& ctx, const std::string& verb) {
+const MarsLanguage& MarsExpension::language(const MarsExpandContext& ctx, const std::string& verb) {
 
     std::string v = MarsLanguage::expandVerb(ctx, verb);
 
-    std::map<std::string, MarsLanguage*>::iterator j = languages_.find(v);
+    std::map<std::string, const MarsLanguage*>::iterator j = languages_.find(v);
     if (j == languages_.end()) {
-        languages_.insert(std::make_pair(v, new MarsLanguage(v)));
-        j = languages_.find(v);
+        j = languages_.insert(std::make_pair(v, &MarsLanguage::instance(v))).first;
     }
     return *(*j).second;
 }
@@ -74,11 +68,8 @@ std::vector<MarsRequest> MarsExpension::expand(const std::vector<MarsParsedReque
     // Implement inheritence
     for (auto j = requests.begin(); j != requests.end(); ++j) {
 
-        MarsLanguage& lang = language((*j), (*j).verb());
-        MarsRequest r = lang.expand(*j, *j, inherit_, strict_);
-
-
-        result.push_back(r);
+        const MarsLanguage& lang = language((*j), (*j).verb());
+        result.push_back(expand(*j, lang, *j));
 
     }
 
@@ -87,13 +78,34 @@ std::vector<MarsRequest> MarsExpension::expand(const std::vector<MarsParsedReque
 
 MarsRequest MarsExpension::expand(const MarsRequest& request) {
     DummyContext ctx;
-    MarsLanguage& lang = language(ctx, request.verb());
-    return lang.expand(ctx, request, inherit_, strict_);
+    const MarsLanguage& lang = language(ctx, request.verb());
+    return expand(ctx, lang, request);
+}
+
+MarsRequest MarsExpension::expand(const MarsExpandContext& ctx, const MarsLanguage& lang, const MarsRequest& request) {
+    ExpansionCache& cache = ExpansionCache::instance();
+    if (!cache.enabled()) {
+        return lang.expand(ctx, request, inherit_, strict_, session_);
+    }
+
+    MarsRequest result;
+    if (cache.lookup(lang, request, inherit_, strict_, session_, result)) {
+        return result;
+    }
+
+    ExpansionSession before;
+    if (inherit_) {
+        before = session_;
+    }
+
+    result = lang.expand(ctx, request, inherit_, strict_, session_);
+    cache.insert(lang, request, inherit_, strict_, before, session_, result);
+    return result;
 }
 
 
 void MarsExpension::expand(const MarsExpandContext& ctx, const MarsRequest& request, ExpandCallback& callback) {
-    MarsRequest r = language(ctx, request.verb()).expand(ctx, request, inherit_, strict_);
+    MarsRequest r = expand(ctx, language(ctx, request.verb()), request);
     callback(ctx, r);
 }
 
@@ -104,6 +116,10 @@ void MarsExpension::flatten(const MarsExpandContext& ctx,
     language(ctx, request.verb()).flatten(ctx, request, callback);
 }
 
+FlattenCursor MarsExpension::cursor(const MarsExpandContext& ctx, const MarsRequest& request) {
+    return FlattenCursor(language(ctx, request.verb()), request);
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 } // namespace mars
 } // namespace metkit
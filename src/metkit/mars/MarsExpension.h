@@ -19,6 +19,8 @@
 
 #include "metkit/mars/MarsRequest.h"
 #include "eckit/memory/NonCopyable.h"
+#include "metkit/mars/ExpansionSession.h"
+#include "metkit/mars/FlattenCursor.h"
 #include "metkit/mars/MarsParsedRequest.h"
 
 
@@ -44,6 +46,10 @@ public:
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/// Expands requests with the process-wide languages (see MarsLanguage::instance()) and its own inheritance
+/// state, so that each thread can have its own MarsExpension at little cost. Requests go through the
+/// ExpansionCache when it is enabled.
+
 class MarsExpension : public eckit::NonCopyable {
 public:
 // -- Contructors
@@ -65,12 +71,19 @@ public:
         const MarsRequest& request,
                  FlattenCallback& callback);
 
+    /// Cursor over the fields of an expanded request, see FlattenCursor
+    FlattenCursor cursor(const MarsExpandContext& ctx, const MarsRequest& request);
+
 
 private: // members
 
-    MarsLanguage& language(const MarsExpandContext&, const std::string& verb);
+    const MarsLanguage& language(const MarsExpandContext&, const std::string& verb);
+
+    /// Expands through the ExpansionCache, when it is enabled
+    MarsRequest expand(const MarsExpandContext&, const MarsLanguage&, const MarsRequest&);
 
-    std::map<std::string, MarsLanguage*> languages_;
+    std::map<std::string, const MarsLanguage*> languages_;
+    ExpansionSession session_;
     bool inherit_;
     bool strict_;
 };
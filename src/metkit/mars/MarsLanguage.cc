@@ -9,7 +9,6 @@
  */
 
 #include <algorithm>
-#include <fstream>
 #include <list>
 #include <set>
 
@@ -17,7 +16,8 @@
 #include "eckit/log/JSON.h"
 #include "eckit/log/Log.h"
 #include "eckit/log/Timer.h"
-#include "eckit/parser/YAMLParser.h"
+#include "eckit/thread/AutoLock.h"
+#include "eckit/thread/Mutex.h"
 #include "eckit/types/Types.h"
 #include "eckit/utils/MD5.h"
 #include "eckit/utils/StringTools.h"
@@ -25,25 +25,31 @@
 
 #include "metkit/config/LibMetkit.h"
 
+#include "metkit/mars/BestMatcher.h"
+#include "metkit/mars/FlattenCursor.h"
 #include "metkit/mars/MarsExpandContext.h"
 #include "metkit/mars/MarsExpension.h"
 #include "metkit/mars/MarsLanguage.h"
 #include "metkit/mars/Type.h"
 #include "metkit/mars/TypesFactory.h"
+#include "metkit/mars/ValueRange.h"
+#include "metkit/mars/YAMLCache.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 
 
 static pthread_once_t once = PTHREAD_ONCE_INIT;
 static eckit::Value languages_;
-static std::vector<std::string> verbs_;
+static metkit::mars::BestMatcher verbs_;
 
 static void init() {
-    languages_ = eckit::YAMLParser::decodeFile(metkit::mars::MarsLanguage::languageYamlFile());
+    languages_ = metkit::mars::YAMLCache::decodeFile(metkit::mars::MarsLanguage::languageYamlFile());
     const eckit::Value verbs = languages_.keys();
+    std::vector<std::string> names;
     for (size_t i = 0; i < verbs.size(); ++i) {
-        verbs_.push_back(verbs[i]);
+        names.push_back(verbs[i]);
     }
+    verbs_ = metkit::mars::BestMatcher(names);
 }
 
 
@@ -53,6 +59,7 @@ namespace mars {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+static const size_t cacheSize = 4096;
 
 MarsLanguage::MarsLanguage(const std::string& verb) : verb_(verb) {
     pthread_once(&once, init);
@@ -63,6 +70,8 @@ MarsLanguage::MarsLanguage(const std::string& verb) : verb_(verb) {
     eckit::Value defaults = lang["_defaults"];
     eckit::Value options  = lang["_options"];
 
+    std::vector<std::string> keywords;
+
     for (size_t i = 0; i < params.size(); ++i) {
         std::string keyword   = params[i];
         eckit::Value settings = lang[keyword];
@@ -87,16 +96,18 @@ MarsLanguage::MarsLanguage(const std::string& verb) : verb_(verb) {
 
         types_[keyword] = TypesFactory::build(keyword, settings);
         types_[keyword]->attach();
-        keywords_.push_back(keyword);
+        keywords.push_back(keyword);
 
         if (settings.contains("aliases")) {
             eckit::Value aliases = settings["aliases"];
             for (size_t j = 0; j < aliases.size(); ++j) {
                 aliases_[aliases[j]] = keyword;
-                keywords_.push_back(aliases[j]);
+                keywords.push_back(aliases[j]);
             }
         }
     }
+
+    keywords_ = BestMatcher(keywords, aliases_);
 }
 
 MarsLanguage::~MarsLanguage() {
@@ -111,164 +122,38 @@ eckit::PathName MarsLanguage::languageYamlFile() {
 
 
 void MarsLanguage::reset() {
-    for (std::map<std::string, Type*>::iterator j = types_.begin(); j != types_.end(); ++j) {
-        (*j).second->reset();
+    session_.reset();
+}
+
+const MarsLanguage& MarsLanguage::instance(const std::string& verb) {
+    static eckit::Mutex mutex;
+    static std::map<std::string, MarsLanguage*> languages;
+
+    eckit::AutoLock<eckit::Mutex> lock(mutex);
+
+    auto j = languages.find(verb);
+    if (j == languages.end()) {
+        j = languages.emplace(verb, new MarsLanguage(verb)).first;
     }
+    return *(*j).second;
 }
 
 eckit::Value MarsLanguage::jsonFile(const std::string& name) {
-    // TODO: cache
-
     eckit::PathName path = std::string("~metkit/share/metkit/" + name);
 
     LOG_DEBUG_LIB(LibMetkit) << "MarsLanguage loading jsonFile " << path << std::endl;
 
-    std::ifstream in(path.asString().c_str());
-    if (!in) {
+    if (!path.exists()) {
         throw eckit::CantOpenFile(path);
     }
 
-    eckit::YAMLParser parser(in);
-
-    return parser.parse();
-}
-
-static bool isnumeric(const std::string& s) {
-    for (size_t i = 0; i < s.length(); i++) {
-        if (!::isdigit(s[i])) {
-            return false;
-        }
-    }
-
-    return s.length() > 0;
+    return YAMLCache::decodeFile(path);
 }
 
 std::string MarsLanguage::bestMatch(const MarsExpandContext& ctx, const std::string& name,
                                     const std::vector<std::string>& values, bool fail, bool quiet,
                                     const std::map<std::string, std::string>& aliases) {
-    size_t score = 1;
-    std::vector<std::string> best;
-
-    static bool strict = eckit::Resource<bool>("$METKIT_LANGUAGE_STRICT_MODE", false);
-
-
-    for (size_t i = 0; i < values.size(); ++i) {
-        const std::string& value = values[i];
-
-        size_t len = std::min(name.length(), value.length());
-        size_t s   = 0;
-
-        for (size_t j = 0; j < len; ++j) {
-            if (::tolower(name[j]) == ::tolower(value[j])) {
-                s++;
-            }
-            else {
-                break;
-            }
-        }
-
-        if (s == value.length() && s == name.length()) {
-            if (aliases.find(value) != aliases.end()) {
-                return aliases.find(value)->second;
-            }
-            return value;
-        }
-
-        if (s >= score) {
-            if (s > score) {
-                best.clear();
-            }
-            best.push_back(value);
-            score = s;
-        }
-    }
-
-    if (!quiet && best.size() > 0) {
-        std::cerr << "Matching '" << name << "' with " << best << ctx << std::endl;
-    }
-
-    // size_t max = 3;
-    // if (best.size() > 0 && score < max) {
-    //     std::cerr << "Matching '"
-    //               << name
-    //               << "' with "
-    //               << best
-    //               << " "
-    //               << "Please give at least " << max << " first letters"
-    //               << std::endl;
-    // }
-
-    if (best.size() == 1) {
-        if (isnumeric(best[0]) && (best[0] != name)) {
-            // std::ostringstream oss;
-            // oss << "Invalid match [" << name << "] and [" << best[0] << "] (ignored)" << ctx;
-            // throw eckit::UserError(oss.str());
-            best.clear();
-        }
-        else {
-            if (strict) {
-                if (best[0] != name) {
-                    std::ostringstream oss;
-                    oss << "Cannot match [" << name << "] in " << values << ctx;
-                    throw eckit::UserError(oss.str());
-                }
-            }
-
-            if (aliases.find(best[0]) != aliases.end()) {
-                return aliases.find(best[0])->second;
-            }
-            return best[0];
-        }
-    }
-
-    if (best.empty()) {
-        if (!fail) {
-            static std::string empty;
-            return empty;
-        }
-
-        std::ostringstream oss;
-        oss << "Cannot match [" << name << "] in " << values << ctx;
-        throw eckit::UserError(oss.str());
-    }
-
-    std::set<std::string> names;
-    for (std::vector<std::string>::const_iterator j = best.begin(); j != best.end(); ++j) {
-        std::map<std::string, std::string>::const_iterator k = aliases.find(*j);
-        if (k == aliases.end()) {
-            names.insert(*j);
-        }
-        else {
-            names.insert((*k).second);
-        }
-    }
-
-    if (names.size() == 1) {
-        if (aliases.find(best[0]) != aliases.end()) {
-            return aliases.find(best[0])->second;
-        }
-        return best[0];
-    }
-
-
-    std::ostringstream oss;
-    oss << "Ambiguous value '" << name << "' could be";
-
-    for (std::vector<std::string>::const_iterator j = best.begin(); j != best.end(); ++j) {
-        std::map<std::string, std::string>::const_iterator k = aliases.find(*j);
-        if (k == aliases.end()) {
-            oss << " '" << *j << "'";
-        }
-        else {
-            oss << " '" << *j << "' (";
-            oss << (*k).second;
-            oss << ")";
-        }
-    }
-
-    oss << ctx;
-
-    throw eckit::UserError(oss.str());
+    return BestMatcher(values, aliases).match(ctx, name, fail, quiet);
 }
 
 std::string MarsLanguage::expandVerb(const MarsExpandContext& ctx, const std::string& verb) {
@@ -279,7 +164,7 @@ std::string MarsLanguage::expandVerb(const MarsExpandContext& ctx, const std::st
     // }
 
     // return cache_[verb] = bestMatch(verb, verbs_, true);
-    return bestMatch(ctx, verb, verbs_, true, true);
+    return verbs_.match(ctx, verb, true, true);
 }
 
 class TypeHidden : public Type {
@@ -307,6 +192,11 @@ Type* MarsLanguage::type(const std::string& name) const {
 
 
 MarsRequest MarsLanguage::expand(const MarsExpandContext& ctx, const MarsRequest& r, bool inherit, bool strict) {
+    return expand(ctx, r, inherit, strict, session_);
+}
+
+MarsRequest MarsLanguage::expand(const MarsExpandContext& ctx, const MarsRequest& r, bool inherit, bool strict,
+                                 ExpansionSession& session) const {
     MarsRequest result(verb_);
 
     try {
@@ -317,12 +207,21 @@ MarsRequest MarsLanguage::expand(const MarsExpandContext& ctx, const MarsRequest
             std::string p;
 
 
-            std::map<std::string, std::string>::iterator c = cache_.find(*j);
-            if (c != cache_.end()) {
-                p = (*c).second;
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex_);
+                std::map<std::string, std::string>::const_iterator c = cache_.find(*j);
+                if (c != cache_.end()) {
+                    p = (*c).second;
+                }
             }
-            else {
-                p = cache_[*j] = bestMatch(ctx, *j, keywords_, true, false, aliases_);
+
+            if (p.empty()) {
+                p = keywords_.match(ctx, *j, true, false);
+                std::unique_lock<std::shared_mutex> lock(mutex_);
+                if (cache_.size() >= cacheSize) {
+                    cache_.clear();
+                }
+                cache_[*j] = p;
             }
 
             // if (seen.find(p) != seen.end()) {
@@ -337,31 +236,52 @@ MarsRequest MarsLanguage::expand(const MarsExpandContext& ctx, const MarsRequest
                 const std::string& s = values[0];
                 if (s == "off" || s == "OFF") {
                     result.unsetValues(p);
-                    type(p)->clearDefaults();
+                    session.clearDefaults(*type(p));
                     continue;
                 }
             }
 
-            type(p)->expand(ctx, values);
-            result.setValuesTyped(type(p), values);
-            type(p)->check(ctx, values);
+            Type* t = type(p);
+
+            if (ValueRange* range = t->range(ctx, values)) {
+                Parameter parameter(range, t);
+                // A range is not checked as a list is: a single-valued keyword must not accept one
+                ASSERT_MSG(t->multiple(), "Range of values for single-valued '" + t->name() + "'");
+                result.setParameter(parameter);
+                continue;
+            }
+
+            t->expand(ctx, values);
+            result.setValuesTyped(t, std::move(values));
+            t->check(ctx, result.values(t->name()));
             // result.setValues(p, values);
         }
 
 
         if (inherit) {
-            for (std::map<std::string, Type*>::iterator k = types_.begin(); k != types_.end();
+            for (std::map<std::string, Type*>::const_iterator k = types_.begin(); k != types_.end();
                  ++k) {
                 const std::string& name = (*k).first;
                 if (result.countValues(name) == 0) {
-                    (*k).second->setDefaults(result);
+                    if (const Parameter* inherited = session.inherited(*(*k).second)) {
+                        if (inherited->size()) {
+                            result.setParameter(*inherited);
+                        }
+                    }
+                    else if (!(*k).second->defaults().empty()) {
+                        result.setValuesTyped((*k).second, (*k).second->defaults());
+                    }
                 }
             }
 
             result.getParams(params);
             for (std::vector<std::string>::const_iterator k = params.begin(); k != params.end();
                  ++k) {
-                type(*k)->setDefaults(result.values(*k));
+                const Type& t = *type(*k);
+                // Hidden keywords (starting with '_') share a type named otherwise, and are not inherited
+                if (const Parameter* p = result.parameter(t.keyword())) {
+                    session.setDefaults(t, *p);
+                }
             }
         }
 
@@ -389,36 +309,18 @@ const std::string& MarsLanguage::verb() const {
 }
 
 
-void MarsLanguage::flatten(const MarsRequest& request, const std::vector<std::string>& params,
-                           size_t i, MarsRequest& result, FlattenCallback& callback) {
-    if (i == params.size()) {
-        callback(result);
-        return;
-    }
-
-    const std::string& param = params[i];
-
-    Type* t = type(param);
-    if (!t->flatten()) {
-        flatten(request, params, i + 1, result, callback);
-        return;
-    }
-
-    const std::vector<std::string>& values = t->flattenValues(request);
-
-    for (std::vector<std::string>::const_iterator j = values.begin(); j != values.end(); ++j) {
-        result.setValue(param, *j);
-        flatten(request, params, i + 1, result, callback);
-    }
-}
-
 void MarsLanguage::flatten(const MarsExpandContext&, const MarsRequest& request,
-                           FlattenCallback& callback) {
-    std::vector<std::string> params;
-    request.getParams(params);
-
+                           FlattenCallback& callback) const {
     MarsRequest result(request);
-    flatten(request, params, 0, result, callback);
+
+    // Only the keywords whose value changed are set again, usually the last one
+    for (FlattenCursor cursor(*this, request); !cursor.done(); cursor.next()) {
+        FlattenCursor::Field field = cursor.field();
+        for (size_t i = cursor.changed(); i < field.size(); ++i) {
+            result.setValue(field.keyword(i), field.value(i));
+        }
+        callback(result);
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -17,6 +17,10 @@
 #ifndef metkit_MarsLanguage_H
 #define metkit_MarsLanguage_H
 
+#include <shared_mutex>
+
+#include "metkit/mars/BestMatcher.h"
+#include "metkit/mars/ExpansionSession.h"
 #include "metkit/mars/MarsRequest.h"
 #include "eckit/memory/NonCopyable.h"
 
@@ -41,13 +45,18 @@ public: // methods
 
     ~MarsLanguage();
 
+    /// Expands with the inheritance state of this language, see reset()
     MarsRequest expand(const MarsExpandContext& ctx, const MarsRequest& r, bool inherit, bool strict);
 
+    /// Expands with the inheritance state of the session; can be called concurrently with other sessions
+    MarsRequest expand(const MarsExpandContext& ctx, const MarsRequest& r, bool inherit, bool strict,
+                       ExpansionSession& session) const;
+
     void reset();
 
     const std::string& verb() const;
 
-    void flatten(const MarsExpandContext& ctx, const MarsRequest& request, FlattenCallback& callback);
+    void flatten(const MarsExpandContext& ctx, const MarsRequest& request, FlattenCallback& callback) const;
 
     static eckit::PathName languageYamlFile();
 
@@ -55,6 +64,9 @@ public: // methods
 
 public: // class methods
 
+    /// Process-wide language of a verb, built on first use and shared by all threads
+    static const MarsLanguage& instance(const std::string& verb);
+
     static std::string expandVerb(const MarsExpandContext&, const std::string& verb);
 
     static std::string bestMatch(const MarsExpandContext& ctx,
@@ -67,23 +79,19 @@ public: // class methods
     static eckit::Value jsonFile(const std::string& name);
 
 
-private: // methods
-
-    void flatten(const MarsRequest& request,
-                 const std::vector<std::string>& params,
-                 size_t i,
-                 MarsRequest& result,
-                 FlattenCallback& callback);
-
 private: // members
 
     std::string verb_;
     std::map<std::string, Type* > types_;
-    std::vector<std::string> keywords_;
+    BestMatcher keywords_;
 
     StringMap aliases_;
 
+    /// Keywords as given and as matched, shared by all threads; cleared when full
     mutable StringMap cache_;
+    mutable std::shared_mutex mutex_;
+
+    ExpansionSession session_;
 
 };
 
@@ -13,6 +13,16 @@
 /// @author Tiago Quintino
 /// @date   Jun 2012
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/filesystem/PathName.h"
+
 #include "metkit/mars/MarsParser.h"
 #include "metkit/mars/MarsParserContext.h"
 
@@ -103,17 +113,18 @@ static bool inindent(char c) {
 }
 
 
-void MarsParser::quoted(std::ostream& out, const std::string& value) {
-    char quote = 0;
+bool MarsParser::needsQuotes(const std::string& value) {
     for (std::string::const_iterator j = value.begin(); j != value.end(); ++j) {
         if (!inindent(*j)) {
-            quote = '"';
-            break;
+            return true;
         }
     }
+    return false;
+}
 
-    if (quote) {
-        out << quote << value << quote;
+void MarsParser::quoted(std::ostream& out, const std::string& value) {
+    if (needsQuotes(value)) {
+        out << '"' << value << '"';
     }
     else {
         out << value;
@@ -200,10 +211,41 @@ MarsParsedRequest MarsParser::parseRequest() {
 }
 
 MarsParser::MarsParser(std::istream &in):
-    StreamParser(in, true, "#")
+    StreamParser(in, false)
 {
 }
 
+char MarsParser::peek(bool spaces) {
+    for (;;) {
+        char c = StreamParser::peek(true);
+        if (spaces || c == 0) {
+            return c;
+        }
+        if (c == '#') {
+            while ((c = StreamParser::peek(true)) != 0 && c != '\n') {
+                StreamParser::next(true);
+            }
+            continue;
+        }
+        if (!isspace(c)) {
+            return c;
+        }
+        StreamParser::next(true);
+    }
+}
+
+char MarsParser::next(bool spaces) {
+    peek(spaces);
+    return StreamParser::next(true);
+}
+
+void MarsParser::consume(char c) {
+    char n = next();
+    if (n != c) {
+        throw StreamParser::Error(std::string("MarsParser: expected '") + c + "', got '" + n + "'", line_ + 1);
+    }
+}
+
 std::vector<MarsParsedRequest> MarsParser::parse()
 {
     std::vector<MarsParsedRequest> result;
@@ -224,6 +266,257 @@ void MarsParser::parse(MarsParserCallback& cb) {
     }
 }
 
+//----------------------------------------------------------------------------------------------------------------------
+
+MarsBufferParser::MarsBufferParser(const char* buffer, size_t length) :
+    begin_(buffer), pos_(buffer), end_(buffer + length), line_(0), mapped_(nullptr), mappedLength_(0) {}
+
+MarsBufferParser::MarsBufferParser(std::string_view text) : MarsBufferParser(text.data(), text.size()) {}
+
+MarsBufferParser::MarsBufferParser(const std::string& text) : MarsBufferParser(text.data(), text.size()) {}
+
+MarsBufferParser::MarsBufferParser(const eckit::PathName& path) :
+    begin_(nullptr), pos_(nullptr), end_(nullptr), line_(0), mapped_(nullptr), mappedLength_(0) {
+    int fd = ::open(path.localPath(), O_RDONLY);
+    if (fd < 0) {
+        throw eckit::CantOpenFile(path);
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+        ::close(fd);
+        throw eckit::FailedSystemCall("fstat " + path.asString());
+    }
+
+    if (st.st_size > 0) {
+        void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            throw eckit::FailedSystemCall("mmap " + path.asString());
+        }
+        mapped_       = p;
+        mappedLength_ = st.st_size;
+    }
+
+    ::close(fd);
+
+    begin_ = pos_ = static_cast<const char*>(mapped_);
+    end_          = begin_ + mappedLength_;
+}
+
+MarsBufferParser::~MarsBufferParser() {
+    if (mapped_) {
+        ::munmap(mapped_, mappedLength_);
+    }
+}
+
+void MarsBufferParser::error(const std::string& msg) const {
+    throw eckit::StreamParser::Error(msg, line_ + 1);
+}
+
+// Comments are skipped between tokens only, like blanks when spaces is false
+
+char MarsBufferParser::peek(bool spaces) {
+    while (pos_ != end_) {
+        char c = *pos_;
+        if (spaces) {
+            return c;
+        }
+        if (c == '#') {
+            while (pos_ != end_ && *pos_ != '\n') {
+                ++pos_;
+            }
+            continue;
+        }
+        if (!isspace(c)) {
+            return c;
+        }
+        if (c == '\n') {
+            line_++;
+        }
+        ++pos_;
+    }
+    return 0;
+}
+
+char MarsBufferParser::next(bool spaces) {
+    char c = peek(spaces);
+    if (pos_ == end_) {
+        error("MarsParser: unexpected end of input");
+    }
+    if (c == '\n') {
+        line_++;
+    }
+    ++pos_;
+    return c;
+}
+
+void MarsBufferParser::consume(char c) {
+    char n = next();
+    if (n != c) {
+        error(std::string("MarsParser: expected '") + c + "', got '" + n + "'");
+    }
+}
+
+std::string MarsBufferParser::parseString(char quote) {
+    consume(quote);
+
+    // Fast path: no escapes before the closing quote
+    const char* start = pos_;
+    while (pos_ != end_ && *pos_ != quote && *pos_ != '\\') {
+        ++pos_;
+    }
+
+    line_ += std::count(start, pos_, '\n');
+    std::string s(start, pos_);
+
+    for (;;) {
+        char c = next(true);
+        if (c == quote) {
+            return s;
+        }
+        if (c != '\\') {
+            s += c;
+            continue;
+        }
+
+        c = next(true);
+        switch (c) {
+            case '"':
+            case '\'':
+            case '\\':
+            case '/':
+                s += c;
+                break;
+            case 'b':
+                s += '\b';
+                break;
+            case 'f':
+                s += '\f';
+                break;
+            case 'n':
+                s += '\n';
+                break;
+            case 'r':
+                s += '\r';
+                break;
+            case 't':
+                s += '\t';
+                break;
+            case 'u':
+                error("MarsParser::parseString \\uXXXX format not supported");
+            default:
+                error(std::string("MarsParser::parseString invalid \\ char '") + c + "'");
+        }
+    }
+}
+
+std::string_view MarsBufferParser::parseIndent() {
+    peek();
+    const char* start = pos_;
+    while (pos_ != end_ && inindent(*pos_)) {
+        ++pos_;
+    }
+    return std::string_view(start, pos_ - start);
+}
+
+std::string MarsBufferParser::parseIndents() {
+    std::string_view first = parseIndent();
+
+    // Words separated by single blanks are returned as they are in the buffer, others are joined
+    const char* start = first.data();
+    const char* end   = pos_;
+    std::string joined;
+    bool contiguous = true;
+
+    for (;;) {
+        size_t blanks = 0;
+        while (pos_ != end_ && *pos_ == ' ') {
+            ++pos_;
+            ++blanks;
+        }
+
+        if (pos_ == end_ || !inindent(*pos_)) {
+            break;
+        }
+
+        std::string_view word = parseIndent();
+
+        if (contiguous && blanks == 1) {
+            end = pos_;
+            continue;
+        }
+
+        if (contiguous) {
+            joined.assign(start, end);
+            contiguous = false;
+        }
+        joined += ' ';
+        joined.append(word.data(), word.size());
+    }
+
+    return contiguous ? std::string(start, end) : joined;
+}
+
+std::string MarsBufferParser::parseValue() {
+    char c = peek();
+
+    if (c == '\"' || c == '\'') {
+        return parseString(c);
+    }
+
+    return parseIndents();
+}
+
+std::vector<std::string> MarsBufferParser::parseValues() {
+    std::vector<std::string> v(1, parseValue());
+    while (peek() == '/') {
+        consume('/');
+        v.push_back(parseValue());
+    }
+    return v;
+}
+
+std::string_view MarsBufferParser::parseVerb() {
+    char c = peek();
+    if (!isalpha(c) && c != '_') {
+        error(std::string("MarsParser::parseVerb invalid char '") + c + "'");
+    }
+    return parseIndent();
+}
+
+MarsParsedRequest MarsBufferParser::parseRequest() {
+    std::string_view verb = parseVerb();
+
+    MarsParsedRequest r(std::string(verb), line_ + 1, pos_ - begin_ + 1);
+
+    while (peek() == ',') {
+        consume(',');
+        std::string key = parseIndents();
+        consume('=');
+        r.values(key, parseValues());
+    }
+
+    return r;
+}
+
+std::vector<MarsParsedRequest> MarsBufferParser::parse() {
+    std::vector<MarsParsedRequest> result;
+
+    while (peek() != 0) {
+        result.push_back(parseRequest());
+    }
+
+    return result;
+}
+
+void MarsBufferParser::parse(MarsParserCallback& cb) {
+    while (peek() != 0) {
+        auto r = parseRequest();
+        cb(r, r);
+    }
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 } // namespace mars
 } // namespace metkit
@@ -14,10 +14,17 @@
 #ifndef metkit_MARSParser_h
 #define metkit_MARSParser_h
 
+#include <string_view>
+
+#include "eckit/memory/NonCopyable.h"
 #include "eckit/parser/StreamParser.h"
 #include "eckit/types/Types.h"
 #include "metkit/mars/MarsParsedRequest.h"
 
+namespace eckit {
+class PathName;
+}
+
 namespace metkit {
 namespace mars {
 
@@ -50,8 +57,16 @@ public: // methods
 
     static void quoted(std::ostream& out, const std::string& value);
 
+    /// Whether quoted() would surround the value with quotes
+    static bool needsQuotes(const std::string& value);
+
 private: // methods
 
+    // Comments are skipped by these, between tokens only, so that a '#' in a quoted value is kept
+    char peek(bool spaces = false);
+    char next(bool spaces = false);
+    void consume(char);
+
     MarsParsedRequest parseRequest();
     std::string parseVerb();
     std::string parseKeyword();
@@ -66,6 +81,61 @@ private: // methods
 
 //----------------------------------------------------------------------------------------------------------------------
 
+/// Parses MARS requests from a contiguous buffer, or a memory-mapped file, with the same grammar, quoting and
+/// escape rules as MarsParser.
+///
+/// Tokens are scanned as ranges of the buffer; strings are only built for the keywords and values stored in the
+/// parsed requests.
+
+class MarsBufferParser : private eckit::NonCopyable {
+
+public: // methods
+
+    /// The buffer must outlive the parser
+    MarsBufferParser(const char* buffer, size_t length);
+    explicit MarsBufferParser(std::string_view);
+    explicit MarsBufferParser(const std::string&);
+    MarsBufferParser(std::string&&) = delete;
+
+    /// Maps the file in memory
+    explicit MarsBufferParser(const eckit::PathName&);
+
+    ~MarsBufferParser();
+
+    std::vector<MarsParsedRequest> parse();
+
+    void parse(MarsParserCallback& cb);
+
+private: // methods
+
+    char peek(bool spaces = false);
+    char next(bool spaces = false);
+    void consume(char);
+
+    MarsParsedRequest parseRequest();
+    std::string_view parseVerb();
+    std::vector<std::string> parseValues();
+    std::string parseValue();
+    std::string_view parseIndent();
+    std::string parseIndents();
+    std::string parseString(char quote);
+
+    [[noreturn]] void error(const std::string&) const;
+
+private: // members
+
+    const char* begin_;
+    const char* pos_;
+    const char* end_;
+    size_t line_;
+
+    void* mapped_;
+    size_t mappedLength_;
+
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
 } // namespace mars
 } // namespace metkit
 
@@ -8,6 +8,9 @@
  * does it submit to any jurisdiction.
  */
 
+#include <algorithm>
+#include <utility>
+
 #include "eckit/log/JSON.h"
 #include "eckit/log/Log.h"
 #include "eckit/types/Types.h"
@@ -16,6 +19,7 @@
 
 #include "eckit/message/Message.h"
 #include "metkit/config/LibMetkit.h"
+#include "metkit/mars/Keyword.h"
 #include "metkit/mars/MarsExpension.h"
 #include "metkit/mars/MarsParser.h"
 #include "metkit/mars/MarsRequest.h"
@@ -31,6 +35,37 @@ MarsRequest::MarsRequest() {}
 
 MarsRequest::MarsRequest(const std::string& s) : verb_(s) {}
 
+MarsRequest::MarsRequest(const MarsRequest& other) :
+    verb_(other.verb_),
+    params_(other.params_),
+    index_(other.index_),
+    hash_(other.hash_.load(std::memory_order_relaxed)) {}
+
+MarsRequest::MarsRequest(MarsRequest&& other) noexcept :
+    verb_(std::move(other.verb_)),
+    params_(std::move(other.params_)),
+    index_(std::move(other.index_)),
+    hash_(other.hash_.load(std::memory_order_relaxed)) {
+    other.changed();
+}
+
+MarsRequest& MarsRequest::operator=(const MarsRequest& other) {
+    verb_   = other.verb_;
+    params_ = other.params_;
+    index_  = other.index_;
+    hash_.store(other.hash_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
+}
+
+MarsRequest& MarsRequest::operator=(MarsRequest&& other) noexcept {
+    verb_   = std::move(other.verb_);
+    params_ = std::move(other.params_);
+    index_  = std::move(other.index_);
+    hash_.store(other.hash_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    other.changed();
+    return *this;
+}
+
 MarsRequest::MarsRequest(const std::string& s, const std::map<std::string, std::string>& values) :
     verb_(s) {
     for (auto j = values.begin(); j != values.end(); ++j) {
@@ -38,7 +73,7 @@ MarsRequest::MarsRequest(const std::string& s, const std::map<std::string, std::
         const std::string& value = (*j).second;
 
 
-        params_.push_back(Parameter(std::vector<std::string>(1, value), new TypeAny(param)));
+        add(Parameter(std::vector<std::string>(1, value), new TypeAny(param)));
     }
 }
 
@@ -52,10 +87,10 @@ MarsRequest::MarsRequest(const std::string& s, const eckit::Value& values) : ver
         if (value.isList()) {
             std::vector<std::string> vals;
             eckit::fromValue(vals, value);
-            params_.push_back(Parameter(vals, new TypeAny(param)));
+            add(Parameter(std::move(vals), new TypeAny(param)));
         }
         else {
-            params_.push_back(Parameter(std::vector<std::string>(1, value), new TypeAny(param)));
+            add(Parameter(std::vector<std::string>(1, value), new TypeAny(param)));
         }
     }
 }
@@ -88,10 +123,10 @@ MarsRequest::MarsRequest(eckit::Stream& s, bool lowercase) {
         for (int k = 0; k < count; k++) {
             std::string value;
             s >> value;
-            v.push_back(value);
+            v.push_back(std::move(value));
         }
 
-        params_.push_back(Parameter(v, new TypeAny(param)));
+        add(Parameter(std::move(v), new TypeAny(param)));
     }
 }
 
@@ -101,7 +136,7 @@ void MarsRequest::encode(eckit::Stream& s) const {
     s << size;
 
 
-    for (std::list<Parameter>::const_iterator i = params_.begin(); i != params_.end(); ++i) {
+    for (std::vector<Parameter>::const_iterator i = params_.begin(); i != params_.end(); ++i) {
         s << (*i).name();
 
         const std::vector<std::string>& v = (*i).values();
@@ -125,8 +160,8 @@ void MarsRequest::print(std::ostream& s) const {
 }
 
 void MarsRequest::dump(std::ostream& s, const char* cr, const char* tab) const {
-    std::list<Parameter>::const_iterator begin = params_.begin();
-    std::list<Parameter>::const_iterator end   = params_.end();
+    std::vector<Parameter>::const_iterator begin = params_.begin();
+    std::vector<Parameter>::const_iterator end   = params_.end();
 
 
     s << verb_;
@@ -135,7 +170,7 @@ void MarsRequest::dump(std::ostream& s, const char* cr, const char* tab) const {
         s << ',' << cr << tab;
 
         int a = 0;
-        for (std::list<Parameter>::const_iterator i = begin; i != end; ++i) {
+        for (std::vector<Parameter>::const_iterator i = begin; i != end; ++i) {
             if (a++) {
                 s << ',';
                 s << cr << tab;
@@ -164,10 +199,10 @@ void MarsRequest::dump(std::ostream& s, const char* cr, const char* tab) const {
 void MarsRequest::json(eckit::JSON& s) const {
     s.startObject();
     // s << "_verb" << verb_;
-    std::list<Parameter>::const_iterator begin = params_.begin();
-    std::list<Parameter>::const_iterator end   = params_.end();
+    std::vector<Parameter>::const_iterator begin = params_.begin();
+    std::vector<Parameter>::const_iterator end   = params_.end();
 
-    for (std::list<Parameter>::const_iterator i = begin; i != end; ++i) {
+    for (std::vector<Parameter>::const_iterator i = begin; i != end; ++i) {
         s << (*i).name();
         const std::vector<std::string>& v = (*i).values();
 
@@ -188,31 +223,107 @@ void MarsRequest::json(eckit::JSON& s) const {
 }
 
 void MarsRequest::md5(eckit::MD5& md5) const {
-    std::ostringstream oss;
-    oss << *this;
-    md5.add(oss.str());
+    // Feeds the same bytes as print(), so digests are unchanged
+    auto add = [&md5](const std::string& s) { md5.add(s.data(), s.size()); };
+
+    add(verb_);
+
+    for (const Parameter& p : params_) {
+        md5.add(",", 1);
+        add(p.name());
+        md5.add("=", 1);
+
+        const std::vector<std::string>& v = p.values();
+        for (std::vector<std::string>::const_iterator k = v.begin(); k != v.end(); ++k) {
+            if (k != v.begin()) {
+                md5.add("/", 1);
+            }
+            if (MarsParser::needsQuotes(*k)) {
+                md5.add("\"", 1);
+                add(*k);
+                md5.add("\"", 1);
+            }
+            else {
+                add(*k);
+            }
+        }
+    }
+}
+
+uint64_t MarsRequest::hash() const {
+    uint64_t h = hash_.load(std::memory_order_relaxed);
+    if (h) {
+        return h;
+    }
+
+    // Order-sensitive combination of std::hash values, as operator== compares parameters in order
+    std::hash<std::string> hasher;
+    auto combine = [&h](uint64_t v) { h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2); };
+
+    h = 0;
+    combine(hasher(verb_));
+    for (const Parameter& p : params_) {
+        combine(p.keyword());
+        const std::vector<std::string>& v = p.values();
+        combine(v.size());
+        for (const std::string& s : v) {
+            combine(hasher(s));
+        }
+    }
+
+    if (!h) {
+        h = 1;
+    }
+    hash_.store(h, std::memory_order_relaxed);
+    return h;
 }
 
 void MarsRequest::unsetValues(const std::string& name) {
-    std::list<Parameter>::iterator i = find(name);
+    changed();
+    std::vector<Parameter>::iterator i = find(name);
     if (i != params_.end()) {
         params_.erase(i);
+        reindex();
     }
 }
 
-void MarsRequest::setValuesTyped(Type* type, const std::vector<std::string>& values) {
-    std::list<Parameter>::iterator i = find(type->name());
+void MarsRequest::setValuesTyped(const Type* type, const std::vector<std::string>& values) {
+    changed();
+    std::vector<Parameter>::iterator i = find(type->name());
     if (i != params_.end()) {
         (*i) = Parameter(values, type);
     }
     else {
-        params_.push_back(Parameter(values, type));
+        add(Parameter(values, type));
+    }
+}
+
+void MarsRequest::setValuesTyped(const Type* type, std::vector<std::string>&& values) {
+    changed();
+    std::vector<Parameter>::iterator i = find(type->name());
+    if (i != params_.end()) {
+        (*i) = Parameter(std::move(values), type);
+    }
+    else {
+        add(Parameter(std::move(values), type));
+    }
+}
+
+void MarsRequest::setParameter(const Parameter& p) {
+    changed();
+    std::vector<Parameter>::iterator i = find(p.name());
+    if (i != params_.end()) {
+        (*i) = p;
+    }
+    else {
+        add(Parameter(p));
     }
 }
 
 bool MarsRequest::filter(const MarsRequest& filter) {
-    for (std::list<Parameter>::iterator i = params_.begin(); i != params_.end(); ++i) {
-        std::list<Parameter>::const_iterator j = filter.find((*i).name());
+    changed();
+    for (std::vector<Parameter>::iterator i = params_.begin(); i != params_.end(); ++i) {
+        std::vector<Parameter>::const_iterator j = filter.find((*i).name());
         if (j == filter.params_.end()) {
             continue;
         }
@@ -227,7 +338,7 @@ bool MarsRequest::filter(const MarsRequest& filter) {
 bool MarsRequest::matches(const MarsRequest& matches) const {
     std::vector<std::string> params = matches.params();
     for (std::vector<std::string>::const_iterator j = params.begin(); j != params.end(); ++j) {
-        std::list<Parameter>::const_iterator k = find(*j);
+        std::vector<Parameter>::const_iterator k = find(*j);
         if (k == params_.end()) {
             return false;
         }
@@ -241,20 +352,32 @@ bool MarsRequest::matches(const MarsRequest& matches) const {
 }
 
 void MarsRequest::values(const std::string& name, const std::vector<std::string>& v) {
-    std::list<Parameter>::iterator i = find(name);
+    changed();
+    std::vector<Parameter>::iterator i = find(name);
     if (i != params_.end()) {
         (*i).values(v);
     }
     else {
-        params_.push_back(Parameter(v, new TypeAny(name)));
+        add(Parameter(v, new TypeAny(name)));
+    }
+}
+
+void MarsRequest::values(const std::string& name, std::vector<std::string>&& v) {
+    changed();
+    std::vector<Parameter>::iterator i = find(name);
+    if (i != params_.end()) {
+        (*i).values(std::move(v));
+    }
+    else {
+        add(Parameter(std::move(v), new TypeAny(name)));
     }
 }
 
 
 size_t MarsRequest::countValues(const std::string& name) const {
-    std::list<Parameter>::const_iterator i = find(name);
+    std::vector<Parameter>::const_iterator i = find(name);
     if (i != params_.end()) {
-        return (*i).values().size();
+        return (*i).size();
     }
     return 0;
 }
@@ -263,9 +386,14 @@ bool MarsRequest::has(const std::string& name) const {
     return find(name) != params_.end();
 }
 
+const Parameter* MarsRequest::parameter(size_t keyword) const {
+    size_t i = position(keyword);
+    return i < params_.size() ? &params_[i] : nullptr;
+}
+
 
 bool MarsRequest::is(const std::string& name, const std::string& value) const {
-    std::list<Parameter>::const_iterator i = find(name);
+    std::vector<Parameter>::const_iterator i = find(name);
     if (i != params_.end()) {
         const std::vector<std::string>& v = (*i).values();
         return v.size() == 1 && v[0] == value;
@@ -274,7 +402,7 @@ bool MarsRequest::is(const std::string& name, const std::string& value) const {
 }
 
 const std::vector<std::string>& MarsRequest::values(const std::string& name, bool emptyOk) const {
-    std::list<Parameter>::const_iterator i = find(name);
+    std::vector<Parameter>::const_iterator i = find(name);
     if (i == params_.end()) {
         if (emptyOk) {
             static std::vector<std::string> empty;
@@ -289,7 +417,7 @@ const std::vector<std::string>& MarsRequest::values(const std::string& name, boo
 }
 
 const std::string& MarsRequest::operator[](const std::string& name) const {
-    std::list<Parameter>::const_iterator i = find(name);
+    std::vector<Parameter>::const_iterator i = find(name);
     if (i == params_.end()) {
         std::ostringstream oss;
         oss << "Parameter '" << name << "' is undefined";
@@ -308,14 +436,14 @@ const std::string& MarsRequest::operator[](const std::string& name) const {
 
 void MarsRequest::getParams(std::vector<std::string>& p) const {
     p.clear();
-    for (std::list<Parameter>::const_iterator i = params_.begin(); i != params_.end(); ++i) {
+    for (std::vector<Parameter>::const_iterator i = params_.begin(); i != params_.end(); ++i) {
         p.push_back((*i).name());
     }
 }
 
 size_t MarsRequest::count() const {
     size_t result = 1;
-    for (std::list<Parameter>::const_iterator i = params_.begin(); i != params_.end(); ++i) {
+    for (std::vector<Parameter>::const_iterator i = params_.begin(); i != params_.end(); ++i) {
         result *= (*i).count();
     }
     return result;
@@ -332,19 +460,32 @@ MarsRequest::operator eckit::Value() const {
 }
 
 void MarsRequest::merge(const MarsRequest& other) {
+    changed();
     for (auto& param : params_) {
-        eckit::Log::debug<LibMetkit>() << "Merging parameter " << param << std::endl;
-        auto it = other.find(param.name());
-        if (it != other.params_.end())
-            param.merge(*it);
+        LOG_DEBUG_LIB(LibMetkit) << "Merging parameter " << param << std::endl;
+        size_t j = other.position(param.keyword());
+        if (j < other.params_.size()) {
+            param.merge(other.params_[j]);
+        }
+    }
+}
+
+void MarsRequest::merge(const MarsRequest& other, std::vector<std::unordered_set<std::string>>& seen) {
+    changed();
+    seen.resize(params_.size());
+    for (size_t i = 0; i < params_.size(); ++i) {
+        size_t j = other.position(params_[i].keyword());
+        if (j < other.params_.size()) {
+            params_[i].merge(other.params_[j], seen[i]);
+        }
     }
 }
 
 MarsRequest MarsRequest::subset(const std::set<std::string>& keys) const {
     MarsRequest req(verb_);
-    for (std::list<Parameter>::const_iterator it = params_.begin(); it != params_.end(); ++it) {
+    for (std::vector<Parameter>::const_iterator it = params_.begin(); it != params_.end(); ++it) {
         if (keys.find(it->name()) != keys.end()) {
-            req.params_.push_back(*it);
+            req.add(Parameter(*it));
         }
     }
     return req;
@@ -353,18 +494,31 @@ MarsRequest MarsRequest::subset(const std::set<std::string>& keys) const {
 
 MarsRequest MarsRequest::extract(const std::string& category) const {
     MarsRequest req(verb_);
-    for (std::list<Parameter>::const_iterator it = params_.begin(); it != params_.end(); ++it) {
+    for (std::vector<Parameter>::const_iterator it = params_.begin(); it != params_.end(); ++it) {
         if (it->type().category() == category) {
-            req.params_.push_back(*it);
+            req.add(Parameter(*it));
         }
     }
     return req;
 }
 
 void MarsRequest::verb(const std::string& verb) {
+    changed();
     verb_ = verb;
 }
 
+bool MarsRequest::operator==(const MarsRequest& other) const {
+    if (verb_ != other.verb_ || params_.size() != other.params_.size()) {
+        return false;
+    }
+    uint64_t h = hash_.load(std::memory_order_relaxed);
+    uint64_t o = other.hash_.load(std::memory_order_relaxed);
+    if (h && o && h != o) {
+        return false;
+    }
+    return params_ == other.params_;
+}
+
 bool MarsRequest::operator<(const MarsRequest& other) const {
     if (verb_ != other.verb_) {
         return verb_ < other.verb_;
@@ -383,22 +537,50 @@ const std::string& MarsRequest::verb() const {
     return verb_;
 }
 
-std::list<Parameter>::const_iterator MarsRequest::find(const std::string& name) const {
-    for (std::list<Parameter>::const_iterator i = params_.begin(); i != params_.end(); ++i) {
-        if ((*i).name() == name) {
-            return i;
-        }
+std::vector<Parameter>::const_iterator MarsRequest::find(const std::string& name) const {
+    size_t id = Keyword::lookup(name);
+    return id == Keyword::npos ? params_.end() : params_.begin() + position(id);
+}
+
+std::vector<Parameter>::iterator MarsRequest::find(const std::string& name) {
+    size_t id = Keyword::lookup(name);
+    return id == Keyword::npos ? params_.end() : params_.begin() + position(id);
+}
+
+size_t MarsRequest::position(size_t keyword) const {
+    auto j = std::lower_bound(index_.begin(), index_.end(), std::make_pair(uint32_t(keyword), uint32_t(0)));
+    if (j != index_.end() && j->first == keyword) {
+        return j->second;
     }
-    return params_.end();
+    return params_.size();
 }
 
-std::list<Parameter>::iterator MarsRequest::find(const std::string& name) {
-    for (std::list<Parameter>::iterator i = params_.begin(); i != params_.end(); ++i) {
-        if ((*i).name() == name) {
-            return i;
-        }
+void MarsRequest::add(Parameter&& p) {
+    changed();
+    uint32_t id = p.keyword();
+    params_.push_back(std::move(p));
+
+    // Like a linear search would, lookups resolve to the first parameter with a given name
+    auto j = std::lower_bound(index_.begin(), index_.end(), std::make_pair(id, uint32_t(0)));
+    if (j == index_.end() || j->first != id) {
+        index_.emplace(j, id, uint32_t(params_.size() - 1));
     }
-    return params_.end();
+}
+
+void MarsRequest::reindex() {
+    index_.clear();
+    index_.reserve(params_.size());
+    for (size_t i = 0; i < params_.size(); ++i) {
+        index_.emplace_back(uint32_t(params_[i].keyword()), uint32_t(i));
+    }
+
+    // Sorted by id then position, the first of each id is the first parameter with that name
+    std::sort(index_.begin(), index_.end());
+    index_.erase(std::unique(index_.begin(), index_.end(),
+                             [](const std::pair<uint32_t, uint32_t>& a, const std::pair<uint32_t, uint32_t>& b) {
+                                 return a.first == b.first;
+                             }),
+                 index_.end());
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -17,6 +17,14 @@
 #ifndef metkit_MarsRequest_H
 #define metkit_MarsRequest_H
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 #include "eckit/value/Value.h"
 #include "metkit/mars/Parameter.h"
 
@@ -46,9 +54,16 @@ public:  // methods
 
     explicit MarsRequest(const eckit::message::Message&);
 
+    MarsRequest(const MarsRequest&);
+    MarsRequest(MarsRequest&&) noexcept;
+    MarsRequest& operator=(const MarsRequest&);
+    MarsRequest& operator=(MarsRequest&&) noexcept;
+
     ~MarsRequest() = default;
 
     bool operator<(const MarsRequest& other) const;
+    bool operator==(const MarsRequest& other) const;
+    bool operator!=(const MarsRequest& other) const { return !(*this == other); }
 
     // eckit::Value&        operator[](const std::string&);
     const std::string&  operator[](const std::string&) const;
@@ -60,6 +75,9 @@ public:  // methods
     size_t countValues(const std::string&) const;
     bool has(const std::string&) const;
 
+    /// Parameter with the given Keyword id, or nullptr if absent
+    const Parameter* parameter(size_t keyword) const;
+
 
     bool is(const std::string& param, const std::string& value) const;
 
@@ -75,6 +93,7 @@ public:  // methods
     void verb(const std::string&);
 
     void values(const std::string&, const std::vector<std::string>&);
+    void values(const std::string&, std::vector<std::string>&&);
 
     template <class T>
     void setValue(const std::string& name, const T& value);
@@ -83,20 +102,39 @@ public:  // methods
 
     void unsetValues(const std::string&);
 
-    /// Merges one MarsRequest into another
-    /// @todo Improve performance -- uses O(N^2) search / merge in std::list's
+    /// Merges one MarsRequest into another: appends to each keyword of this request the values of
+    /// other that are not already present, preserving order. Keywords only in other are ignored.
     void merge(const MarsRequest& other);
 
+    /// Same as calling merge() on each request in turn, but in a single pass with per-keyword
+    /// seen-sets kept across inputs
+    template <class Iterator>
+    void mergeAll(Iterator begin, Iterator end);
+
+    template <class Range>
+    void mergeAll(const Range& requests) {
+        mergeAll(std::begin(requests), std::end(requests));
+    }
+
     /// Create a new MarsRequest from this one with only the given set of keys
     MarsRequest subset(const std::set<std::string>&) const;
 
     void json(eckit::JSON&) const;
 
+    /// Digest of the printed request, computed without printing it
     void md5(eckit::MD5&) const;
 
+    /// Fast, non-cryptographic hash of the verb, keywords and values, cached until the request changes.
+    /// Not stable across processes: use md5() for persistent keys.
+    uint64_t hash() const;
+
     void dump(std::ostream&, const char* cr = "\n", const char* tab = "\t") const;
 
-    void setValuesTyped(Type*, const std::vector<std::string>&);
+    void setValuesTyped(const Type*, const std::vector<std::string>&);
+    void setValuesTyped(const Type*, std::vector<std::string>&&);
+
+    /// Sets a parameter as it is, e.g. one holding a symbolic range or taken from another request
+    void setParameter(const Parameter&);
 
     bool filter(const MarsRequest& filter);
     bool matches(const MarsRequest& filter) const;
@@ -112,14 +150,31 @@ public:  // static methods
 
 private:  // members
     std::string verb_;
-    std::list<Parameter> params_;
+
+    /// Parameters in insertion order
+    std::vector<Parameter> params_;
+
+    /// Keyword id and position in params_ of each parameter, sorted by id, so that it grows with the request
+    /// rather than with the number of keywords of the process
+    std::vector<std::pair<uint32_t, uint32_t>> index_;
+
+    /// Cached result of hash(), 0 when not computed
+    mutable std::atomic<uint64_t> hash_{0};
 
 private:  // methods
     void print(std::ostream&) const;
     void encode(eckit::Stream&) const;
 
-    std::list<Parameter>::const_iterator find(const std::string&) const;
-    std::list<Parameter>::iterator find(const std::string&);
+    std::vector<Parameter>::const_iterator find(const std::string&) const;
+    std::vector<Parameter>::iterator find(const std::string&);
+
+    /// Position in params_ of the parameter with the given keyword id, params_.size() if absent
+    size_t position(size_t keyword) const;
+
+    void add(Parameter&&);
+    void reindex();
+    void merge(const MarsRequest& other, std::vector<std::unordered_set<std::string>>& seen);
+    void changed() { hash_.store(0, std::memory_order_relaxed); }
 
     // -- Class members
 
@@ -159,11 +214,18 @@ size_t MarsRequest::getValues(const std::string& name, std::vector<T>& v, bool e
 }
 
 
+template <class Iterator>
+void MarsRequest::mergeAll(Iterator begin, Iterator end) {
+    std::vector<std::unordered_set<std::string>> seen;
+    for (; begin != end; ++begin) {
+        merge(*begin, seen);
+    }
+}
+
 template <class T>
 void MarsRequest::setValue(const std::string& name, const T& value) {
     eckit::Translator<T, std::string> t;
-    std::vector<std::string> v(1, t(value));
-    values(name, v);
+    values(name, std::vector<std::string>(1, t(value)));
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -171,4 +233,13 @@ void MarsRequest::setValue(const std::string& name, const T& value) {
 }  // namespace mars
 }  // namespace metkit
 
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace std {
+template <>
+struct hash<metkit::mars::MarsRequest> {
+    size_t operator()(const metkit::mars::MarsRequest& r) const { return r.hash(); }
+};
+}  // namespace std
+
 #endif
@@ -0,0 +1,189 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+
+#include "eckit/exception/Exceptions.h"
+#include "eckit/serialisation/MemoryStream.h"
+
+#include "metkit/mars/MarsRequest.h"
+#include "metkit/mars/MarsRequestView.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+// Tags written by eckit::Stream before each item, not part of its interface (see MarsRequestView.h)
+const unsigned char tagInt    = 5;
+const unsigned char tagString = 15;
+
+void check(const char* p, const char* end, size_t n) {
+    if (size_t(end - p) < n) {
+        throw eckit::BadValue("MarsRequestView: truncated request");
+    }
+}
+
+void expect(const char*& p, const char* end, unsigned char tag) {
+    check(p, end, 1);
+    if (static_cast<unsigned char>(*p) != tag) {
+        std::ostringstream oss;
+        oss << "MarsRequestView: unexpected tag " << int(static_cast<unsigned char>(*p)) << ", expected "
+            << int(tag);
+        throw eckit::BadValue(oss.str());
+    }
+    ++p;
+}
+
+uint32_t get32(const char*& p, const char* end) {
+    check(p, end, 4);
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    p += 4;
+    return (uint32_t(u[0]) << 24) | (uint32_t(u[1]) << 16) | (uint32_t(u[2]) << 8) | uint32_t(u[3]);
+}
+
+size_t getCount(const char*& p, const char* end) {
+    expect(p, end, tagInt);
+    int32_t n = static_cast<int32_t>(get32(p, end));
+    if (n < 0) {
+        throw eckit::BadValue("MarsRequestView: negative count");
+    }
+    return n;
+}
+
+std::string_view getString(const char*& p, const char* end) {
+    expect(p, end, tagString);
+    size_t len = get32(p, end);
+    check(p, end, len);
+    std::string_view s(p, len);
+    p += len;
+    return s;
+}
+
+}  // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string_view MarsRequestView::Values::iterator::operator*() const {
+    const char* p = pos_;
+    return getString(p, end_);
+}
+
+MarsRequestView::Values::iterator& MarsRequestView::Values::iterator::operator++() {
+    getString(pos_, end_);
+    if (--left_ == 0) {
+        pos_ = end_ = nullptr;
+    }
+    return *this;
+}
+
+std::string_view MarsRequestView::Values::operator[](size_t i) const {
+    ASSERT(i < size_);
+    const char* p = pos_;
+    for (size_t j = 0; j < i; ++j) {
+        getString(p, end_);
+    }
+    return getString(p, end_);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MarsRequestView::MarsRequestView(const void* buffer, size_t length) :
+    begin_(static_cast<const char*>(buffer)), end_(begin_ + length), params_(begin_) {
+    verb_ = getString(params_, end_);
+    size_ = getCount(params_, end_);
+}
+
+template <class F>
+bool MarsRequestView::visit(F f) const {
+    const char* p = params_;
+    for (size_t i = 0; i < size_; ++i) {
+        std::string_view name = getString(p, end_);
+        size_t count          = getCount(p, end_);
+
+        if (f(name, Values(p, end_, count))) {
+            return true;
+        }
+
+        for (size_t j = 0; j < count; ++j) {
+            getString(p, end_);
+        }
+    }
+    return false;
+}
+
+bool MarsRequestView::has(std::string_view keyword) const {
+    return visit([keyword](std::string_view name, const Values&) { return name == keyword; });
+}
+
+size_t MarsRequestView::countValues(std::string_view keyword) const {
+    return values(keyword).size();
+}
+
+MarsRequestView::Values MarsRequestView::values(std::string_view keyword) const {
+    Values result;
+    visit([keyword, &result](std::string_view name, const Values& v) {
+        if (name == keyword) {
+            result = v;
+            return true;
+        }
+        return false;
+    });
+    return result;
+}
+
+std::vector<std::string_view> MarsRequestView::params() const {
+    std::vector<std::string_view> result;
+    result.reserve(size_);
+    visit([&result](std::string_view name, const Values&) {
+        result.push_back(name);
+        return false;
+    });
+    return result;
+}
+
+size_t MarsRequestView::encodedSize() const {
+    const char* p = params_;
+    for (size_t i = 0; i < size_; ++i) {
+        getString(p, end_);
+        size_t count = getCount(p, end_);
+        for (size_t j = 0; j < count; ++j) {
+            getString(p, end_);
+        }
+    }
+    return p - begin_;
+}
+
+MarsRequest MarsRequestView::request(bool lowercase) const {
+    eckit::MemoryStream s(begin_, encodedSize());
+    return MarsRequest(s, lowercase);
+}
+
+void MarsRequestView::print(std::ostream& s) const {
+    s << verb_;
+    visit([&s](std::string_view name, const Values& values) {
+        s << ',' << name << '=';
+        const char* sep = "";
+        for (std::string_view v : values) {
+            s << sep << v;
+            sep = "/";
+        }
+        return false;
+    });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
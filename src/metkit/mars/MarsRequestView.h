@@ -0,0 +1,144 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   MarsRequestView.h
+/// @date   Oct 2026
+
+#ifndef metkit_MarsRequestView_H
+#define metkit_MarsRequestView_H
+
+#include <cstddef>
+#include <iosfwd>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+namespace metkit {
+namespace mars {
+
+class MarsRequest;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Read-only view of a MarsRequest serialised with operator<<(eckit::Stream&, const MarsRequest&), over the
+/// encoded bytes (e.g. an eckit::MemoryStream buffer).
+///
+/// Nothing is decoded up front: lookups walk the encoded keywords, skipping their values, and return
+/// string_views into the buffer, which must outlive the view. Use request() to get a full MarsRequest.
+///
+/// The layout is the eckit::Stream encoding of: verb, number of keywords, then for each keyword its name,
+/// number of values and values. Strings are a tag byte, a 32-bit big-endian length and the bytes; integers
+/// a tag byte and a 32-bit big-endian value.
+///
+/// These tags and sizes are details of eckit::Stream, which does not publish them: the view is tied to the
+/// encoding of the eckit it is built with. test_metkit_request_view_stream checks them against eckit::Stream.
+
+class MarsRequestView {
+public:  // types
+    /// Range over the values of a keyword
+    class Values {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = std::string_view;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const std::string_view*;
+            using reference         = std::string_view;
+
+            std::string_view operator*() const;
+            iterator& operator++();
+            iterator operator++(int) {
+                iterator i = *this;
+                ++(*this);
+                return i;
+            }
+
+            bool operator==(const iterator& other) const { return left_ == other.left_; }
+            bool operator!=(const iterator& other) const { return left_ != other.left_; }
+
+        private:
+            iterator(const char* pos, const char* end, size_t left) : pos_(pos), end_(end), left_(left) {}
+
+            const char* pos_;
+            const char* end_;
+            size_t left_;
+
+            friend class Values;
+        };
+
+        iterator begin() const { return iterator(pos_, end_, size_); }
+        iterator end() const { return iterator(nullptr, nullptr, 0); }
+
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        std::string_view operator[](size_t i) const;
+
+    private:
+        Values() : pos_(nullptr), end_(nullptr), size_(0) {}
+        Values(const char* pos, const char* end, size_t size) : pos_(pos), end_(end), size_(size) {}
+
+        const char* pos_;
+        const char* end_;
+        size_t size_;
+
+        friend class MarsRequestView;
+    };
+
+public:  // methods
+    MarsRequestView(const void* buffer, size_t length);
+
+    std::string_view verb() const { return verb_; }
+
+    bool has(std::string_view keyword) const;
+    size_t countValues(std::string_view keyword) const;
+
+    /// Values of the keyword, empty if absent
+    Values values(std::string_view keyword) const;
+
+    /// Names of the keywords, in order
+    std::vector<std::string_view> params() const;
+
+    /// Number of bytes taken by the encoded request, to find the next one in a batch
+    size_t encodedSize() const;
+
+    /// Decodes the whole request
+    MarsRequest request(bool lowercase = false) const;
+
+private:  // methods
+    void print(std::ostream&) const;
+
+    /// Calls f(name, values) on each keyword until it returns true; returns whether one did
+    template <class F>
+    bool visit(F f) const;
+
+    friend std::ostream& operator<<(std::ostream& s, const MarsRequestView& r) {
+        r.print(s);
+        return s;
+    }
+
+private:  // members
+    const char* begin_;
+    const char* end_;
+
+    /// First byte after the verb and number of keywords
+    const char* params_;
+
+    std::string_view verb_;
+    size_t size_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
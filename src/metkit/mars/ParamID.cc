@@ -16,9 +16,9 @@
 #include "eckit/utils/Tokenizer.h"
 #include "eckit/config/Resource.h"
 #include "eckit/system/Library.h"
-#include "eckit/parser/YAMLParser.h"
 
 #include "metkit/config/LibMetkit.h"
+#include "metkit/mars/YAMLCache.h"
 
 using namespace eckit;
 
@@ -41,7 +41,7 @@ static void readTable()
 {
     eckit::PathName paramMatchingPath = eckit::Resource<eckit::PathName>("paramMatchingPath;$PARAM_MATCHING_PATH", LibMetkit::paramMatchingYamlFile());
 
-    const eckit::Value paramMatching = eckit::YAMLParser::decodeFile(paramMatchingPath);
+    const eckit::Value paramMatching = mars::YAMLCache::decodeFile(paramMatchingPath);
     const eckit::Value wind = paramMatching["wind"];
     ASSERT(wind.isList());
     for (size_t i = 0; i < wind.size(); ++i) {
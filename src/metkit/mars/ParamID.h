@@ -21,6 +21,8 @@
 #include <set>
 #include <algorithm>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "eckit/config/Resource.h"
 #include "eckit/filesystem/PathName.h"
@@ -49,6 +51,37 @@ public: // types
             u_(u), v_(v), vo_(vo), d_(d) {}
     };
 
+    /// Hashed views of an axis of params, built once and reused by callers normalising many requests
+    /// against the same axis
+    class Index {
+    public:
+        template <typename AXIS_T>
+        explicit Index(const AXIS_T& axis);
+
+        bool contains(const Param& p) const { return params_.find(p) != params_.end(); }
+
+        /// Param of the axis with the given param id (the last one, if several), or null
+        const Param* paramId(long paramid) const {
+            auto j = paramIds_.find(paramid);
+            return j == paramIds_.end() ? nullptr : &(*j).second;
+        }
+
+        /// Param of the axis with the same param id modulo 1000 and the lowest param id, or null
+        const Param* anyTable(long paramid) const {
+            auto j = anyTable_.find(paramid % 1000);
+            return j == anyTable_.end() ? nullptr : &(*j).second;
+        }
+
+    private:
+        struct Hash {
+            size_t operator()(const Param& p) const { return std::hash<long>()(p.value() * 1000003 + p.table()); }
+        };
+
+        std::unordered_set<Param, Hash> params_;
+        std::unordered_map<long, Param> paramIds_;
+        std::unordered_map<long, Param> anyTable_;
+    };
+
 public: // methods
 
     template <typename REQUEST_T, typename AXIS_T>
@@ -56,6 +89,15 @@ public: // methods
                           std::vector<Param>& req,
                           const AXIS_T& axis,
                           bool& windConversion,
+                          bool fullTableDropping = ParamID::fullTableDropping()) {
+        normalise(r, req, Index(axis), windConversion, fullTableDropping);
+    }
+
+    template <typename REQUEST_T>
+    static void normalise(const REQUEST_T& r,
+                          std::vector<Param>& req,
+                          const Index& axis,
+                          bool& windConversion,
                           bool fullTableDropping = ParamID::fullTableDropping());
 
     static const std::vector<WindFamily>& getWindFamilies();
@@ -70,10 +112,29 @@ inline long replaceTable(size_t table, long paramid) {
     return (table*1000 + paramid%1000);
 }
 
-template <typename REQUEST_T, typename AXIS_T>
+template <typename AXIS_T>
+ParamID::Index::Index(const AXIS_T& axis) {
+    for (typename AXIS_T::const_iterator j = axis.begin(); j != axis.end(); ++j) {
+        const Param& p = *j;
+        long paramid   = p.paramId();
+
+        params_.insert(p);
+        paramIds_[paramid] = p;
+
+        auto k = anyTable_.find(paramid % 1000);
+        if (k == anyTable_.end()) {
+            anyTable_.emplace(paramid % 1000, p);
+        }
+        else if (paramid <= (*k).second.paramId()) {
+            (*k).second = p;
+        }
+    }
+}
+
+template <typename REQUEST_T>
 void ParamID::normalise(const REQUEST_T& request,
                         std::vector<Param>& req,
-                        const AXIS_T& axis,
+                        const Index& axis,
                         bool& windConversion,
                         bool fullTableDropping) {
 
@@ -84,12 +145,6 @@ void ParamID::normalise(const REQUEST_T& request,
 
     if (useGRIBParamID) {
 
-
-        std::set<Param> inAxis;
-        for (typename AXIS_T::const_iterator j = axis.begin(); j != axis.end(); ++j) {
-            inAxis.insert((*j));
-        }
-
         std::vector<Param> newreq; newreq.reserve(req.size());
 
         for (std::vector<Param>::const_iterator k = req.begin(); k != req.end(); ++k) {
@@ -106,10 +161,10 @@ void ParamID::normalise(const REQUEST_T& request,
                 alt = Param(t == 0 ? 128 : t, v); // '.' version
             }
 
-            if (inAxis.find(p) != inAxis.end()) {
+            if (axis.contains(p)) {
                 newreq.push_back(p);
             }
-            else if (inAxis.find(alt) != inAxis.end()) {
+            else if (axis.contains(alt)) {
                 newreq.push_back(alt);
             } else {
                 newreq.push_back(p);
@@ -156,16 +211,10 @@ void ParamID::normalise(const REQUEST_T& request,
             // if (wantVO && wantD)  continue;
             // if (!wantU && !wantV) continue;
 
-            // Check if we have got it, axis should be sorted
-
-            bool gotU = false;
-            bool gotV = false;
+            // Check if we have got it
 
-            if (wantU)
-                gotU = std::binary_search(axis.begin(), axis.end(), windU);
-
-            if (wantV)
-                gotV = std::binary_search(axis.begin(), axis.end(), windV);
+            bool gotU = wantU && axis.contains(windU);
+            bool gotV = wantV && axis.contains(windV);
 
 
             if ( (wantU && !gotU) || (wantV && !gotV))
@@ -183,33 +232,25 @@ void ParamID::normalise(const REQUEST_T& request,
 
         std::vector<std::pair<Param, Param> > tableDropped;
 
-        std::set<Param> inAxis;
-        std::map<long, Param> inAxisParamID;
         std::set<Param> wind;
 
-        for (typename AXIS_T::const_iterator j = axis.begin(); j != axis.end(); ++j) {
-            inAxis.emplace(*j);
-            inAxisParamID[j->paramId()] = *j;
-        }
-
         std::vector<Param> newreq; newreq.reserve(req.size());
 
         for (auto r: req) {
-            if (inAxis.find(r) != inAxis.end()) { // Perfect match - not looking forward
+            if (axis.contains(r)) { // Perfect match - not looking forward
                 newreq.push_back(r);
             }
             else { // r is normalised to ParamID
                 long paramid = r.paramId();
-                auto ap = inAxisParamID.find(paramid);
-                if (ap != inAxisParamID.end()) { // ParamID representation matching - not looking forward
-                    newreq.push_back(ap->second);
+                if (const Param* ap = axis.paramId(paramid)) { // ParamID representation matching - not looking forward
+                    newreq.push_back(*ap);
                 }
                 else { // Special case for U/V - exact match
                     bool ok = false;
                     for (eckit::Ordinal w = 0; w < windFamilies.size() ; w++) {
                         if ((paramid == windFamilies[w].u_.paramId() || paramid == windFamilies[w].u_.grib1value() ||
                              paramid == windFamilies[w].v_.paramId() || paramid == windFamilies[w].v_.grib1value()) &&
-                            inAxis.find(windFamilies[w].vo_) != inAxis.end() && inAxis.find(windFamilies[w].d_) != inAxis.end()) {
+                            axis.contains(windFamilies[w].vo_) && axis.contains(windFamilies[w].d_)) {
 
                             if (paramid == windFamilies[w].u_.paramId() || paramid == windFamilies[w].u_.grib1value())
                                 newreq.push_back(windFamilies[w].u_);
@@ -227,9 +268,8 @@ void ParamID::normalise(const REQUEST_T& request,
                     if (!ok && r.table() == 0 && paramid < 1000) { // Partial match (only it table has not been specified by user)
                         const std::vector<size_t>& dropTables = ParamID::getDropTables();
                         for (auto t: dropTables) {
-                            auto ap = inAxisParamID.find(replaceTable(t, paramid));
-                            if (ap != inAxisParamID.end()) { // ParamID representation matching - not looking forward
-                                newreq.push_back(ap->second);
+                            if (const Param* ap = axis.paramId(replaceTable(t, paramid))) { // ParamID representation matching - not looking forward
+                                newreq.push_back(*ap);
                                 ok = true;
                                 break;
                             }
@@ -239,18 +279,18 @@ void ParamID::normalise(const REQUEST_T& request,
                             for (eckit::Ordinal w = 0; !ok && w < windFamilies.size() ; w++) {
                                 if (paramid == windFamilies[w].u_.paramId() || paramid == windFamilies[w].v_.paramId()) {
                                     for (auto t: dropTables) {
-                                        auto vo = inAxisParamID.find(replaceTable(t, windFamilies[w].vo_.paramId()));
-                                        auto d  = inAxisParamID.find(replaceTable(t, windFamilies[w].d_.paramId()));
+                                        const Param* vo = axis.paramId(replaceTable(t, windFamilies[w].vo_.paramId()));
+                                        const Param* d  = axis.paramId(replaceTable(t, windFamilies[w].d_.paramId()));
 
-                                        if (vo != inAxisParamID.end() && d != inAxisParamID.end()) {
-                                            bool grib1 = vo->second.table()>0;
+                                        if (vo && d) {
+                                            bool grib1 = vo->table()>0;
                                             if (paramid == windFamilies[w].u_.paramId())
                                                 newreq.push_back(grib1 ? Param(t, paramid) : Param(0, replaceTable(t, paramid)));
                                             else
                                                 newreq.push_back(grib1 ? Param(t, paramid) : Param(0, replaceTable(t, paramid)));
 
-                                            wind.emplace(vo->second);
-                                            wind.emplace(d->second);
+                                            wind.emplace(*vo);
+                                            wind.emplace(*d);
                                             windConversion = true;
 
                                             ok = true;
@@ -263,13 +303,10 @@ void ParamID::normalise(const REQUEST_T& request,
                             }
                         }
                         if (fullTableDropping && !ok) { // Backward compatibility - Partial match (drop completely table information)
-                            for(auto ap: inAxisParamID) {
-                                if (ap.first%1000 == paramid%1000) {
-                                    newreq.push_back(ap.second);
-                                    ok = true;
-                                    tableDropped.push_back(std::make_pair(r, ap.second));
-                                    break;
-                                }
+                            if (const Param* ap = axis.anyTable(paramid)) {
+                                newreq.push_back(*ap);
+                                ok = true;
+                                tableDropped.push_back(std::make_pair(r, *ap));
                             }
                         }
                     }
@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <utility>
 
 #include "metkit/mars/Parameter.h"
 #include "metkit/mars/Type.h"
@@ -39,70 +40,219 @@ static UndefinedType undefined;
 //----------------------------------------------------------------------------------------------------------------------
 
 
-Parameter::Parameter() : type_(&undefined) {
+const std::vector<std::string> Parameter::empty_;
+
+Parameter::Parameter() : type_(&undefined), shared_(nullptr), pooled_(nullptr), range_(nullptr) {
     type_->attach();
 }
 
 Parameter::~Parameter() {
+    release();
     type_->detach();
 }
 
-Parameter::Parameter(const std::vector<std::string>& values, Type* type) :
-    type_(type), values_(values) {
+Parameter::Parameter(const std::vector<std::string>& values, const Type* type) :
+    type_(type), shared_(nullptr), pooled_(nullptr), range_(nullptr) {
     if (!type) {
         type_ = &undefined;
     }
     type_->attach();
+    assign(values);
 }
 
+Parameter::Parameter(std::vector<std::string>&& values, const Type* type) :
+    type_(type), shared_(nullptr), pooled_(nullptr), range_(nullptr) {
+    if (!type) {
+        type_ = &undefined;
+    }
+    type_->attach();
+    assign(std::move(values));
+}
+
+Parameter::Parameter(ValueRange* range, const Type* type) :
+    type_(type), shared_(nullptr), pooled_(nullptr), range_(range) {
+    ASSERT(range);
+    if (!type) {
+        type_ = &undefined;
+    }
+    type_->attach();
+    range_->attach();
+}
 
-Parameter::Parameter(const Parameter& other) : type_(other.type_), values_(other.values_) {
+Parameter::Parameter(const Parameter& other) :
+    type_(other.type_), shared_(other.shared_), pooled_(other.pooled_), range_(other.range_) {
     type_->attach();
+    if (shared_) {
+        shared_->attach();
+    }
+    if (range_) {
+        range_->attach();
+    }
+}
+
+Parameter::Parameter(Parameter&& other) noexcept :
+    type_(other.type_), shared_(other.shared_), pooled_(other.pooled_), range_(other.range_) {
+    // The moved-from parameter keeps a valid type, so that it can still be destroyed or assigned to
+    other.type_ = &undefined;
+    other.type_->attach();
+    other.shared_ = nullptr;
+    other.pooled_ = nullptr;
+    other.range_  = nullptr;
 }
 
 Parameter& Parameter::operator=(const Parameter& other) {
-    Type* old = type_;
+    const Type* old = type_;
     type_     = other.type_;
     type_->attach();
     old->detach();
 
-    values_ = other.values_;
+    if (other.shared_) {
+        other.shared_->attach();
+    }
+    if (other.range_) {
+        other.range_->attach();
+    }
+    release();
+    shared_ = other.shared_;
+    pooled_ = other.pooled_;
+    range_  = other.range_;
     return *this;
 }
 
+Parameter& Parameter::operator=(Parameter&& other) noexcept {
+    if (this != &other) {
+        std::swap(type_, other.type_);
+        std::swap(shared_, other.shared_);
+        std::swap(pooled_, other.pooled_);
+        std::swap(range_, other.range_);
+    }
+    return *this;
+}
+
+void Parameter::release() {
+    if (shared_) {
+        shared_->detach();
+        shared_ = nullptr;
+    }
+    pooled_ = nullptr;
+    if (range_) {
+        range_->detach();
+        range_ = nullptr;
+    }
+}
+
+/// Most values pooled by parameters. Dates and times come from requests and the pool is never freed, so beyond
+/// this, new values are held by the parameter as any other value.
+static const size_t pooledValues = 65536;
+
+template <class V>
+void Parameter::assign(V&& values) {
+    release();
+    if (values.size() == 1 && type_->interned()) {
+        pooled_ = StringPool::values().intern(values[0], pooledValues);
+    }
+    if (!pooled_ && !values.empty()) {
+        shared_ = new Values(std::forward<V>(values));
+        shared_->attach();
+    }
+}
+
+std::vector<std::string>& Parameter::modify() {
+    if (shared_ && shared_->count() == 1) {
+        return shared_->list_;
+    }
+
+    Values* v = new Values(values());
+    v->attach();
+    release();
+    shared_ = v;
+    return shared_->list_;
+}
+
+void Parameter::pool() {
+    if (shared_ && shared_->list_.size() == 1 && type_->interned()) {
+        if (const StringPool::Entry* e = StringPool::values().intern(shared_->list_[0], pooledValues)) {
+            release();
+            pooled_ = e;
+        }
+    }
+}
+
 void Parameter::values(const std::vector<std::string>& values) {
-    values_ = values;
+    assign(values);
+}
+
+void Parameter::values(std::vector<std::string>&& values) {
+    assign(std::move(values));
 }
 
 bool Parameter::filter(const std::vector<std::string>& filter) {
-    return type_->filter(filter, values_);
+    bool ok = type_->filter(filter, modify());
+    pool();
+    return ok;
 }
 
 
 bool Parameter::matches(const std::vector<std::string>& match) const {
-    return type_->matches(match, values_);
+    return type_->matches(match, values());
 }
 
 void Parameter::merge(const Parameter& p) {
     ASSERT(name() == p.name());
 
-    /// @note this isn't optimal O(N^2) but it respects the order
+    const std::vector<std::string>& values = this->values();
+    const std::vector<std::string>& theirs = p.values();
+
+    // Scanning for a few values is cheaper than hashing the whole list, as for an accumulating merge
+    if (theirs.size() > 8 && values.size() > 8) {
+        std::unordered_set<std::string> seen;
+        merge(p, seen);
+        return;
+    }
 
     std::vector<std::string> diff;
-    for (auto& o : p.values_) {
-        bool found = false;
-        for (auto& v : values_) {
-            if (v == o) {
-                found = true;
-                break;
-            }
+    for (auto& o : theirs) {
+        if (std::find(values.begin(), values.end(), o) == values.end()) {
+            diff.push_back(o);
         }
-        if (!found)
+    }
+
+    if (diff.empty()) {
+        return;
+    }
+
+    std::vector<std::string>& v = modify();
+    v.insert(v.end(), std::make_move_iterator(diff.begin()), std::make_move_iterator(diff.end()));
+}
+
+void Parameter::merge(const Parameter& p, std::unordered_set<std::string>& seen) {
+    ASSERT(name() == p.name());
+
+    if ((pooled_ && pooled_ == p.pooled_) || (shared_ && shared_ == p.shared_)) {
+        return;
+    }
+
+    const std::vector<std::string>& values = this->values();
+    if (seen.empty()) {
+        seen.insert(values.begin(), values.end());
+    }
+
+    // Like the short-list path, values repeated within p but new to this are all kept
+    std::vector<std::string> diff;
+    for (auto& o : p.values()) {
+        if (seen.find(o) == seen.end()) {
             diff.push_back(o);
+        }
+    }
+
+    if (diff.empty()) {
+        return;
     }
 
-    values_.insert(values_.end(), std::make_move_iterator(diff.begin()),
-                   std::make_move_iterator(diff.end()));
+    seen.insert(diff.begin(), diff.end());
+
+    std::vector<std::string>& v = modify();
+    v.insert(v.end(), std::make_move_iterator(diff.begin()), std::make_move_iterator(diff.end()));
 }
 
 
@@ -110,19 +260,36 @@ const std::string& Parameter::name() const {
     return type_->name();
 }
 
+size_t Parameter::keyword() const {
+    return type_->keyword();
+}
+
 size_t Parameter::count() const {
-    return type_->count(values_);
+    return range_ ? type_->count(*range_) : type_->count(values());
 }
 
 void Parameter::print(std::ostream& s) const {
-    s << "Parameter[type=" << *type_ << ",values=" << values_ << "]";
+    s << "Parameter[type=" << *type_ << ",values=" << values() << "]";
 }
 
 bool Parameter::operator<(const Parameter& other) const {
     if (name() != other.name()) {
         return name() < other.name();
     }
-    return values_ < other.values_;
+    return values() < other.values();
+}
+
+bool Parameter::operator==(const Parameter& other) const {
+    if (name() != other.name()) {
+        return false;
+    }
+    if ((pooled_ && pooled_ == other.pooled_) || (shared_ && shared_ == other.shared_)) {
+        return true;
+    }
+    if (range_ && other.range_ && *range_ == *other.range_) {
+        return true;
+    }
+    return values() == other.values();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -17,12 +17,18 @@
 #ifndef metkit_Parameter_H
 #define metkit_Parameter_H
 
+#include <unordered_set>
+
+#include "eckit/memory/Counted.h"
 #include "eckit/types/Date.h"
 #include "eckit/types/Double.h"
 #include "eckit/types/Time.h"
 #include "eckit/utils/Translator.h"
 #include "eckit/value/Value.h"
 
+#include "metkit/mars/StringPool.h"
+#include "metkit/mars/ValueRange.h"
+
 namespace eckit {
 class JSON;
 class MD5;
@@ -42,36 +48,87 @@ public:  // methods
     Parameter();
     ~Parameter();
 
-    Parameter(const std::vector<std::string>& values, Type* = 0);
+    Parameter(const std::vector<std::string>& values, const Type* = 0);
+    Parameter(std::vector<std::string>&& values, const Type* = 0);
+    /// Values of a symbolic range, see ValueRange
+    Parameter(ValueRange* range, const Type*);
     Parameter(const Parameter&);
+    Parameter(Parameter&&) noexcept;
 
     Parameter& operator=(const Parameter&);
+    Parameter& operator=(Parameter&&) noexcept;
     bool operator<(const Parameter&) const;
+    bool operator==(const Parameter&) const;
+
+    /// Values, materialising those of a range
+    const std::vector<std::string>& values() const {
+        return pooled_ ? pooled_->list() : (shared_ ? shared_->list_ : (range_ ? range_->list() : empty_));
+    }
+
+    /// Number of values, without materialising a range
+    size_t size() const { return pooled_ ? 1 : (shared_ ? shared_->list_.size() : (range_ ? range_->size() : 0)); }
+
+    /// Range the values are taken from, or null if they are a list
+    const ValueRange* range() const { return range_; }
+
+    /// Entry of the value in StringPool::values(), or null unless the type is interned and there is one value
+    const StringPool::Entry* pooled() const { return pooled_; }
 
-    const std::vector<std::string>& values() const { return values_; }
     void values(const std::vector<std::string>& values);
+    void values(std::vector<std::string>&& values);
 
     bool filter(const std::vector<std::string>& filter);
     bool matches(const std::vector<std::string>& matches) const;
 
+    /// Appends the values of p that are not already present, preserving order
     void merge(const Parameter& p);
 
-    Type& type() const { return *type_; }
+    /// As merge(), with seen holding the current values (filled on first use), so it can be reused
+    /// across successive merges into the same parameter
+    void merge(const Parameter& p, std::unordered_set<std::string>& seen);
+
+    const Type& type() const { return *type_; }
     const std::string& name() const;
+    size_t keyword() const;
 
     size_t count() const;
 
+private:  // types
+    /// Value list shared between copies of a Parameter, never modified while shared
+    class Values : public eckit::Counted {
+    public:
+        explicit Values(const std::vector<std::string>& list) : list_(list) {}
+        explicit Values(std::vector<std::string>&& list) : list_(std::move(list)) {}
+        std::vector<std::string> list_;
+    };
+
 private:  // methods
     void print(std::ostream&) const;
 
+    template <class V>
+    void assign(V&& values);
+    void release();
+    void pool();
+
+    /// Returns a list owned only by this Parameter, copying it if it is shared
+    std::vector<std::string>& modify();
+
     friend std::ostream& operator<<(std::ostream& s, const Parameter& p) {
         p.print(s);
         return s;
     }
 
 private:  // members
-    Type* type_;
-    std::vector<std::string> values_;
+    const Type* type_;
+    Values* shared_;
+
+    /// Set instead of shared_ when the type is interned and there is a single value
+    const StringPool::Entry* pooled_;
+
+    /// Set instead of shared_ when the values are a range given as from/to/by
+    ValueRange* range_;
+
+    static const std::vector<std::string> empty_;
 };
 
 
@@ -15,6 +15,8 @@
 #define metkit_StepRangeNormalise_H
 
 #include <algorithm>
+#include <functional>
+#include <unordered_set>
 
 #include "eckit/exception/Exceptions.h"
 #include "metkit/mars/StepRange.h"
@@ -32,15 +34,37 @@ namespace mars {
 class StepRangeNormalise {
 public:
 
+    /// Hashed view of an axis of steps, built once and reused by callers normalising many requests
+    /// against the same axis
+    class Index {
+    public:
+        template <typename AXIS_T>
+        explicit Index(const AXIS_T& axis) : steps_(axis.begin(), axis.end()) {}
+
+        bool contains(const StepRange& s) const { return steps_.find(s) != steps_.end(); }
+
+    private:
+        struct Hash {
+            size_t operator()(const StepRange& s) const {
+                return std::hash<double>()(s.from()) * 31 + std::hash<double>()(s.to());
+            }
+        };
+
+        std::unordered_set<StepRange, Hash> steps_;
+    };
+
     template <typename AXIS_T>
-    static void normalise(std::vector<StepRange>& v, const AXIS_T& axis);
+    static void normalise(std::vector<StepRange>& v, const AXIS_T& axis) {
+        normalise(v, Index(axis));
+    }
+
+    static void normalise(std::vector<StepRange>& v, const Index& axis);
 
 };
 
 //----------------------------------------------------------------------------------------------------------------------
 
-template <typename AXIS_T>
-void StepRangeNormalise::normalise(std::vector<StepRange>& values, const AXIS_T& axis) {
+inline void StepRangeNormalise::normalise(std::vector<StepRange>& values, const Index& axis) {
 
     std::vector<StepRange> outputValues;
 
@@ -48,8 +72,7 @@ void StepRangeNormalise::normalise(std::vector<StepRange>& values, const AXIS_T&
 
         // If the supplied range is found in the axis, then use that
 
-        auto j = std::find(axis.begin(), axis.end(), values[i]);
-        if (j != axis.end()) {
+        if (axis.contains(values[i])) {
             outputValues.push_back(values[i]);
 
             // If specified, and matched, a RANGE, then use that
@@ -63,9 +86,9 @@ void StepRangeNormalise::normalise(std::vector<StepRange>& values, const AXIS_T&
         double singleValue = values[i].from();
 
         if (values[i].from() != values[i].to()) {
-            j = std::find(axis.begin(), axis.end(), StepRange(singleValue, singleValue));
-            if (j != axis.end()) {
-                outputValues.push_back(*j);
+            StepRange single(singleValue, singleValue);
+            if (axis.contains(single)) {
+                outputValues.push_back(single);
                 matched = true;
             }
         }
@@ -73,16 +96,16 @@ void StepRangeNormalise::normalise(std::vector<StepRange>& values, const AXIS_T&
         // If singleValue == 0, this test is the same as the previous one...
 
         if (singleValue != 0) {
-            j = std::find(axis.begin(), axis.end(), StepRange(0, singleValue));
-            if (j != axis.end()) {
+            StepRange range(0, singleValue);
+            if (axis.contains(range)) {
 
                 if (matched) {
                     eckit::Log::userWarning() << "Step " << values[i]
                                               << " matches " << values[i]
-                                              << " and " << (*j) << std::endl;
+                                              << " and " << range << std::endl;
                 }
 
-                outputValues.push_back(*j);
+                outputValues.push_back(range);
             }
         }
     }
@@ -0,0 +1,108 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <functional>
+
+#include "eckit/thread/AutoLock.h"
+
+#include "metkit/mars/StringPool.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr size_t StringPool::buckets_;
+
+StringPool::StringPool() : size_(0) {
+    for (size_t i = 0; i < buckets_; ++i) {
+        heads_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+StringPool::~StringPool() {
+    for (size_t i = 0; i < buckets_; ++i) {
+        const Entry* e = heads_[i].load(std::memory_order_relaxed);
+        while (e) {
+            const Entry* next = e->next_;
+            delete e;
+            e = next;
+        }
+    }
+}
+
+size_t StringPool::bucket(const std::string& s) {
+    return std::hash<std::string>()(s) & (buckets_ - 1);
+}
+
+const StringPool::Entry* StringPool::search(const Entry* e, const std::string& s) {
+    for (; e; e = e->next_) {
+        if (e->str() == s) {
+            return e;
+        }
+    }
+    return nullptr;
+}
+
+const StringPool::Entry* StringPool::find(const std::string& s) const {
+    return search(heads_[bucket(s)].load(std::memory_order_acquire), s);
+}
+
+const StringPool::Entry& StringPool::intern(const std::string& s) {
+    return *intern(s, size_t(-1));
+}
+
+const StringPool::Entry* StringPool::intern(const std::string& s, size_t limit) {
+    size_t b = bucket(s);
+
+    const Entry* e = search(heads_[b].load(std::memory_order_acquire), s);
+    if (e) {
+        return e;
+    }
+
+    eckit::AutoLock<eckit::Mutex> lock(mutex_);
+
+    const Entry* head = heads_[b].load(std::memory_order_relaxed);
+    e                 = search(head, s);
+    if (e) {
+        return e;
+    }
+
+    size_t n = size_.load(std::memory_order_relaxed);
+    if (n >= limit) {
+        return nullptr;
+    }
+
+    e = new Entry(s, n, head);
+    heads_[b].store(e, std::memory_order_release);
+    size_.store(n + 1, std::memory_order_release);
+    return e;
+}
+
+size_t StringPool::size() const {
+    return size_.load(std::memory_order_acquire);
+}
+
+// The pools are intentionally never destroyed: handles may still be held by static objects at exit
+
+StringPool& StringPool::keywords() {
+    static StringPool* pool = new StringPool();
+    return *pool;
+}
+
+StringPool& StringPool::values() {
+    static StringPool* pool = new StringPool();
+    return *pool;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
@@ -0,0 +1,101 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   StringPool.h
+/// @date   Oct 2026
+
+#ifndef metkit_StringPool_H
+#define metkit_StringPool_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "eckit/memory/NonCopyable.h"
+#include "eckit/thread/Mutex.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Thread-safe, append-only pool of immutable strings.
+///
+/// Interning a string returns a handle (an Entry) that stays valid for the lifetime of the process, so
+/// equal strings can be shared and compared by address. Each entry also owns a one-element value list,
+/// which lets a Parameter holding a single interned value point at the pool instead of owning a vector.
+///
+/// Lookups walk the hash chains without locking; only the insertion of a new string takes the mutex.
+///
+/// Strings are never removed, so strings from an open set (such as dates coming from requests) should only be
+/// added up to a limit, with intern(string, limit).
+
+class StringPool : private eckit::NonCopyable {
+public:  // types
+    class Entry {
+    public:
+        const std::string& str() const { return list_[0]; }
+        const std::vector<std::string>& list() const { return list_; }
+
+        /// Dense, per-pool id, starting from 0
+        size_t id() const { return id_; }
+
+    private:
+        Entry(const std::string& s, size_t id, const Entry* next) : list_(1, s), id_(id), next_(next) {}
+
+        std::vector<std::string> list_;
+        size_t id_;
+        const Entry* next_;
+
+        friend class StringPool;
+    };
+
+public:  // methods
+    StringPool();
+    ~StringPool();
+
+    /// Returns the entry for the string, adding it if needed
+    const Entry& intern(const std::string&);
+
+    /// Returns the entry for the string, adding it only if the pool holds fewer than limit strings; nullptr if
+    /// the string is not in a full pool
+    const Entry* intern(const std::string&, size_t limit);
+
+    /// Returns the entry for the string, or nullptr if it was never interned
+    const Entry* find(const std::string&) const;
+
+    /// Number of strings in the pool
+    size_t size() const;
+
+public:  // class methods
+    /// Pool of keyword names
+    static StringPool& keywords();
+
+    /// Pool of tidied values, see Type::interned()
+    static StringPool& values();
+
+private:  // members
+    static constexpr size_t buckets_ = 4096;
+
+    std::atomic<const Entry*> heads_[buckets_];
+    std::atomic<size_t> size_;
+    eckit::Mutex mutex_;
+
+private:  // methods
+    static size_t bucket(const std::string&);
+    static const Entry* search(const Entry*, const std::string&);
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
@@ -9,17 +9,21 @@
  */
 
 #include <algorithm>
+#include <unordered_set>
 
+#include "metkit/mars/Keyword.h"
 #include "metkit/mars/MarsExpandContext.h"
 #include "metkit/mars/MarsRequest.h"
+#include "metkit/mars/StringPool.h"
 #include "metkit/mars/Type.h"
+#include "metkit/mars/ValueRange.h"
 
 namespace metkit {
 namespace mars {
 //----------------------------------------------------------------------------------------------------------------------
 
 Type::Type(const std::string& name, const eckit::Value& settings) :
-    name_(name), flatten_(true), multiple_(false), duplicates_(true) {
+    name_(name), keyword_(Keyword::id(name)), flatten_(true), multiple_(false), duplicates_(true), interned_(false) {
     if (settings.contains("multiple")) {
         multiple_ = settings["multiple"];
     }
@@ -51,55 +55,82 @@ Type::Type(const std::string& name, const eckit::Value& settings) :
         }
     }
 
-    originalDefaults_ = defaults_;
-
     if (settings.contains("only")) {
-        eckit::Value d = settings["only"];
+        only_ = constraints(settings["only"]);
+    }
+
+    if (settings.contains("never")) {
+        never_ = constraints(settings["never"]);
+    }
+}
 
-        size_t len = d.size();
-        for (size_t i = 0; i < len; i++) {
-            eckit::Value a    = d[i];
-            eckit::Value keys = a.keys();
+std::vector<Type::Constraint> Type::constraints(const eckit::Value& rules) {
+    std::map<std::string, std::set<std::string> > values;
 
-            for (size_t j = 0; j < keys.size(); j++) {
-                std::string key = keys[j];
-                eckit::Value v  = a[key];
+    size_t len = rules.size();
+    for (size_t i = 0; i < len; i++) {
+        eckit::Value a    = rules[i];
+        eckit::Value keys = a.keys();
 
-                if (v.isList()) {
-                    for (size_t k = 0; k < v.size(); k++) {
-                        only_[key].insert(v[k]);
-                    }
-                }
-                else {
-                    only_[key].insert(v);
+        for (size_t j = 0; j < keys.size(); j++) {
+            std::string key = keys[j];
+            eckit::Value v  = a[key];
+
+            if (v.isList()) {
+                for (size_t k = 0; k < v.size(); k++) {
+                    values[key].insert(v[k]);
                 }
             }
+            else {
+                values[key].insert(v);
+            }
         }
     }
 
-    if (settings.contains("never")) {
-        eckit::Value d = settings["never"];
+    // Values are interned, so that a request value missing from the pool is known not to be listed
+    std::vector<Constraint> result;
+    for (const auto& kv : values) {
+        Constraint c;
+        c.name    = kv.first;
+        c.keyword = Keyword::id(kv.first);
+        c.values  = kv.second;
+
+        std::vector<size_t> ids;
+        size_t size = 0;
+        for (const std::string& s : kv.second) {
+            ids.push_back(StringPool::values().intern(s).id());
+            size = std::max(size, ids.back() + 1);
+        }
 
-        size_t len = d.size();
-        for (size_t i = 0; i < len; i++) {
-            eckit::Value a    = d[i];
-            eckit::Value keys = a.keys();
+        c.ids.resize(size);
+        for (size_t id : ids) {
+            c.ids.set(id);
+        }
 
-            for (size_t j = 0; j < keys.size(); j++) {
-                std::string key = keys[j];
-                eckit::Value v  = a[key];
+        result.push_back(std::move(c));
+    }
 
-                if (v.isList()) {
-                    for (size_t k = 0; k < v.size(); k++) {
-                        never_[key].insert(v[k]);
-                    }
-                }
-                else {
-                    never_[key].insert(v);
-                }
-            }
+    return result;
+}
+
+const std::string* Type::Constraint::find(const MarsRequest& request, bool listed) const {
+    const Parameter* p = request.parameter(keyword);
+    if (!p) {
+        return nullptr;
+    }
+
+    if (const StringPool::Entry* e = p->pooled()) {
+        return contains(e->id()) == listed ? &e->str() : nullptr;
+    }
+
+    const StringPool& pool = StringPool::values();
+    for (const std::string& value : p->values()) {
+        const StringPool::Entry* e = pool.find(value);
+        if ((e && contains(e->id())) == listed) {
+            return &value;
         }
     }
+    return nullptr;
 }
 
 Type::~Type() {}
@@ -112,36 +143,44 @@ size_t Type::count(const std::vector<std::string>& values) const {
     return flatten_ ? values.size() : 1;
 }
 
-class NotInSet {
-    std::set<std::string> set_;
+size_t Type::count(const ValueRange& range) const {
+    return flatten_ ? range.size() : 1;
+}
+
+/// Membership test against filter values: short lists are scanned, longer ones hashed
+class ValueSet {
+    const std::vector<std::string>& values_;
+    std::unordered_set<std::string> set_;
 
 public:
-    NotInSet(const std::vector<std::string>& f) : set_(f.begin(), f.end()) {}
+    ValueSet(const std::vector<std::string>& f) : values_(f) {
+        if (f.size() > 8) {
+            set_.insert(f.begin(), f.end());
+        }
+    }
 
-    bool operator()(const std::string& s) const { return set_.find(s) == set_.end(); }
+    bool contains(const std::string& s) const {
+        if (values_.size() > 8) {
+            return set_.find(s) != set_.end();
+        }
+        return std::find(values_.begin(), values_.end(), s) != values_.end();
+    }
 };
 
 bool Type::filter(const std::vector<std::string>& filter, std::vector<std::string>& values) const {
-    NotInSet not_in_set(filter);
+    ValueSet set(filter);
 
-    values.erase(std::remove_if(values.begin(), values.end(), not_in_set), values.end());
+    values.erase(std::remove_if(values.begin(), values.end(), [&set](const std::string& s) { return !set.contains(s); }),
+                 values.end());
 
     return !values.empty();
 }
 
-class InSet {
-    std::set<std::string> set_;
-
-public:
-    InSet(const std::vector<std::string>& f) : set_(f.begin(), f.end()) {}
-
-    bool operator()(const std::string& s) const { return set_.find(s) != set_.end(); }
-};
-
 bool Type::matches(const std::vector<std::string>& match,
                    const std::vector<std::string>& values) const {
-    InSet in_set(match);
-    return std::find_if(values.begin(), values.end(), in_set) != values.end();
+    ValueSet set(match);
+    return std::find_if(values.begin(), values.end(), [&set](const std::string& s) { return set.contains(s); }) !=
+           values.end();
 }
 
 
@@ -181,61 +220,39 @@ bool Type::expand(const MarsExpandContext&, std::string& value) const {
     throw eckit::SeriousBug(oss.str());
 }
 
-void Type::expand(const MarsExpandContext& ctx, std::vector<std::string>& values) const {
-    std::vector<std::string> newvals;
+ValueRange* Type::range(const MarsExpandContext&, const std::vector<std::string>&) const {
+    return nullptr;
+}
 
+void Type::expand(const MarsExpandContext& ctx, std::vector<std::string>& values) const {
     std::set<std::string> seen;
 
-    for (std::vector<std::string>::const_iterator j = values.begin(); j != values.end(); ++j) {
-        std::string value = *j;
+    // Values are expanded in place; expand() leaves a value untouched when it fails
+    for (std::vector<std::string>::iterator j = values.begin(); j != values.end(); ++j) {
+        std::string& value = *j;
         if (!expand(ctx, value)) {
             std::ostringstream oss;
-            oss << *this << ": cannot expand '" << *j << "'" << ctx;
+            oss << *this << ": cannot expand '" << value << "'" << ctx;
             throw eckit::UserError(oss.str());
         }
 
-        if (!duplicates_) {
-            if (seen.find(value) != seen.end()) {
-                std::ostringstream oss;
-                oss << *this << ": duplicated value '" << *j << "'" << ctx;
-                throw eckit::UserError(oss.str());
-            }
-            seen.insert(value);
+        // Checked locally: interning the values here would grow the pool with every date and time ever seen
+        if (!duplicates_ && !seen.insert(value).second) {
+            std::ostringstream oss;
+            oss << *this << ": duplicated value '" << value << "'" << ctx;
+            throw eckit::UserError(oss.str());
         }
-
-        newvals.push_back(value);
     }
 
-    std::swap(newvals, values);
-
     if (!multiple_ && values.size() > 1) {
         throw eckit::UserError("Only one value passible for '" + name_ + "'");
     }
 }
 
-void Type::setDefaults(MarsRequest& request) {
-    if (!defaults_.empty()) {
-        request.setValuesTyped(this, defaults_);
-    }
-}
-
-void Type::setDefaults(const std::vector<std::string>& defaults) {
-    defaults_ = defaults;
-}
-
-const std::vector<std::string>& Type::flattenValues(const MarsRequest& request) {
+const std::vector<std::string>& Type::flattenValues(const MarsRequest& request) const {
     return request.values(name_);
 }
 
-
-void Type::clearDefaults() {
-    defaults_.clear();
-}
-
-void Type::reset() {
-    defaults_ = originalDefaults_;
-}
-
 const std::string& Type::name() const {
     return name_;
 }
@@ -245,55 +262,39 @@ const std::string& Type::category() const {
     return category_;
 }
 
-void Type::pass2(const MarsExpandContext& ctx, MarsRequest& request) {}
+void Type::pass2(const MarsExpandContext& ctx, MarsRequest& request) const {}
 
-void Type::finalise(const MarsExpandContext& ctx, MarsRequest& request, bool strict) {
+void Type::finalise(const MarsExpandContext& ctx, MarsRequest& request, bool strict) const {
     bool ok = true;
 
-    const std::vector<std::string>& values = request.values(name_, true);
-    if (values.size() == 1 && values[0] == "off") {
+    const Parameter* self = request.parameter(keyword_);
+    if (self && self->size() == 1 && self->values()[0] == "off") {
         ok = false;
     }
 
-    for (std::map<std::string, std::set<std::string> >::const_iterator j = only_.begin();
-         ok && j != only_.end(); ++j) {
-        const std::string& name           = (*j).first;
-        const std::set<std::string>& only = (*j).second;
-
-        const std::vector<std::string>& values = request.values(name, true);
-        for (std::vector<std::string>::const_iterator k = values.begin(); ok && k != values.end();
-             ++k) {
-            if (only.find(*k) == only.end()) {
-                std::ostringstream oss;
-                oss << "Key [" << name_ << "] not acceptable since " << name << "=" << *k << " not listed in " << name_ << "->only->" << name << ": " << only << " in MARS language definition" << std::endl;
-                if (strict) {
-                    throw eckit::UserError(oss.str());
-                } else {
-                    eckit::Log::userWarning() << oss.str();
-                }
-                ok = false;
+    for (std::vector<Constraint>::const_iterator j = only_.begin(); ok && j != only_.end(); ++j) {
+        if (const std::string* value = (*j).find(request, false)) {
+            std::ostringstream oss;
+            oss << "Key [" << name_ << "] not acceptable since " << (*j).name << "=" << *value << " not listed in " << name_ << "->only->" << (*j).name << ": " << (*j).values << " in MARS language definition" << std::endl;
+            if (strict) {
+                throw eckit::UserError(oss.str());
+            } else {
+                eckit::Log::userWarning() << oss.str();
             }
+            ok = false;
         }
     }
 
-    for (std::map<std::string, std::set<std::string> >::const_iterator j = never_.begin();
-         ok && j != never_.end(); ++j) {
-        const std::string& name            = (*j).first;
-        const std::set<std::string>& never = (*j).second;
-
-        const std::vector<std::string>& values = request.values(name, true);
-        for (std::vector<std::string>::const_iterator k = values.begin(); ok && k != values.end();
-             ++k) {
-            if (never.find(*k) != never.end()) {
-                std::ostringstream oss;
-                oss << "Key [" << name_ << "] not acceptable since " << name << "=" << *k << " listed in " << name_ << "->never->" << name << ": " << never << " in MARS language definition" << std::endl;
-                if (strict) {
-                    throw eckit::UserError(oss.str());
-                } else {
-                    eckit::Log::userWarning() << oss.str();
-                }
-                ok = false;
+    for (std::vector<Constraint>::const_iterator j = never_.begin(); ok && j != never_.end(); ++j) {
+        if (const std::string* value = (*j).find(request, true)) {
+            std::ostringstream oss;
+            oss << "Key [" << name_ << "] not acceptable since " << (*j).name << "=" << *value << " listed in " << name_ << "->never->" << (*j).name << ": " << (*j).values << " in MARS language definition" << std::endl;
+            if (strict) {
+                throw eckit::UserError(oss.str());
+            } else {
+                eckit::Log::userWarning() << oss.str();
             }
+            ok = false;
         }
     }
 
@@ -16,18 +16,23 @@
 #ifndef metkit_Type_H
 #define metkit_Type_H
 
+#include <set>
 #include <string>
+#include <vector>
 
 #include "eckit/memory/Counted.h"
 #include "eckit/types/Types.h"
 #include "eckit/value/Value.h"
 
+#include "metkit/mars/Bitset.h"
+
 
 namespace metkit {
 namespace mars {
 
 class MarsRequest;
 class MarsExpandContext;
+class ValueRange;
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -39,20 +44,21 @@ public:  // methods
                         std::vector<std::string>& values) const;
     virtual bool expand(const MarsExpandContext& ctx, std::string& value) const;
 
+    /// Returns the values as a symbolic range if they are a single from/to/by that expand() would turn
+    /// into the same list, or null to expand them. Ranges skip expand() and check(), so only types taking
+    /// several values, without duplicates, may return one
+    virtual ValueRange* range(const MarsExpandContext& ctx, const std::vector<std::string>& values) const;
+
     virtual std::string tidy(const MarsExpandContext& ctx, const std::string& value) const;
     virtual std::string tidy(const std::string& value) const;
     virtual std::vector<std::string> tidy(const std::vector<std::string>& values) const;
 
-    virtual void setDefaults(MarsRequest& request);
-    virtual void setDefaults(const std::vector<std::string>& defaults);
     virtual void check(const MarsExpandContext& ctx, const std::vector<std::string>& values) const;
-    virtual void clearDefaults();
-    virtual void reset();
 
-    virtual void pass2(const MarsExpandContext& ctx, MarsRequest& request);
-    virtual void finalise(const MarsExpandContext& ctx, MarsRequest& request, bool strict);
+    virtual void pass2(const MarsExpandContext& ctx, MarsRequest& request) const;
+    virtual void finalise(const MarsExpandContext& ctx, MarsRequest& request, bool strict) const;
 
-    virtual const std::vector<std::string>& flattenValues(const MarsRequest& request);
+    virtual const std::vector<std::string>& flattenValues(const MarsRequest& request) const;
     virtual bool flatten() const;
 
     virtual bool filter(const std::vector<std::string>& filter,
@@ -63,28 +69,62 @@ public:  // methods
     const std::string& name() const;
     const std::string& category() const;
 
+    /// Defaults from the language definition; inherited ones are kept in an ExpansionSession
+    const std::vector<std::string>& defaults() const { return defaults_; }
+
+    /// Whether the keyword takes more than one value
+    bool multiple() const { return multiple_; }
+
+    /// Process-wide id of this type's name, see Keyword
+    size_t keyword() const { return keyword_; }
+
+    /// Whether single tidied values are shared through StringPool::values(), up to a limit (see Parameter)
+    bool interned() const { return interned_; }
+
     friend std::ostream& operator<<(std::ostream& s, const Type& x);
 
     virtual size_t count(const std::vector<std::string>& values) const;
+    virtual size_t count(const ValueRange& range) const;
+
+protected:  // types
+    /// Values of another keyword listed by an only or never rule
+    struct Constraint {
+        std::string name;
+        size_t keyword;
+
+        /// As in the language definition, for the messages
+        std::set<std::string> values;
+
+        /// Ids of the values in StringPool::values()
+        Bitset ids;
+
+        bool contains(size_t id) const { return id < ids.size() && ids.test(id); }
+
+        /// First value of the keyword in the request that is (or is not) listed, or null if there is none
+        const std::string* find(const MarsRequest& request, bool listed) const;
+    };
 
 protected:  // members
     std::string name_;
     std::string category_;
+    size_t keyword_;
 
     std::vector<std::string> defaults_;
     bool flatten_;
     bool multiple_;
     bool duplicates_;
+    bool interned_;
 
-    std::vector<std::string> originalDefaults_;
-
-    std::map<std::string, std::set<std::string> > only_;
-    std::map<std::string, std::set<std::string> > never_;
+    /// Sorted by keyword name, as they are checked by finalise()
+    std::vector<Constraint> only_;
+    std::vector<Constraint> never_;
 
 protected:  // methods
     virtual ~Type() override;
 
 private:  // methods
+    static std::vector<Constraint> constraints(const eckit::Value& rules);
+
     virtual void print(std::ostream& out) const = 0;
 };
 
@@ -18,6 +18,7 @@
 #include "eckit/utils/StringTools.h"
 
 #include "metkit/mars/MarsExpandContext.h"
+#include "metkit/mars/ValueRange.h"
 
 
 namespace metkit {
@@ -29,13 +30,13 @@ TypeDate::TypeDate(const std::string &name, const eckit::Value& settings) :
     Type(name, settings),
     by_(1) {
 
+    interned_ = true;
+
     DummyContext ctx;
 
-    for (size_t i = 0; i < originalDefaults_.size(); i++ ) {
-        originalDefaults_[i] = tidy(ctx, originalDefaults_[i]);
+    for (size_t i = 0; i < defaults_.size(); i++ ) {
+        defaults_[i] = tidy(ctx, defaults_[i]);
     }
-
-    defaults_ = originalDefaults_;
 }
 
 TypeDate::~TypeDate() {
@@ -56,6 +57,36 @@ bool TypeDate::expand(const MarsExpandContext& ctx, std::string &value) const {
 }
 
 
+static std::string formatDate(long julian) {
+    static eckit::Translator<long, std::string> l2s;
+    return l2s(eckit::Date::julianToDate(julian));
+}
+
+ValueRange* TypeDate::range(const MarsExpandContext& ctx, const std::vector<std::string>& values) const {
+
+    static eckit::Translator<std::string, long> s2l;
+    static eckit::Translator<long, std::string> l2s;
+
+    if (!multiple_) {
+        return nullptr;
+    }
+
+    bool to = (values.size() == 3 || values.size() == 5) && eckit::StringTools::lower(values[1])[0] == 't';
+    if (!to || (values.size() == 5 && eckit::StringTools::lower(values[3]) != "by")) {
+        return nullptr;
+    }
+
+    eckit::Date from = tidy(ctx, values[0]);
+    eckit::Date last = tidy(ctx, values[2]);
+    long by = values.size() == 5 ? s2l(tidy(ctx, values[4])) : by_;
+
+    if (by <= 0 || last < from) {
+        return nullptr;
+    }
+
+    return new ValueRange(l2s(from.yyyymmdd()), from.julian(), last.julian(), by, formatDate);
+}
+
 void TypeDate::expand(const MarsExpandContext& ctx, std::vector<std::string>& values) const {
 
     static eckit::Translator<std::string, long> s2l;
@@ -22,8 +22,12 @@ namespace mars {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+static const size_t cacheSize = 4096;
+
 TypeEnum::TypeEnum(const std::string& name, const eckit::Value& settings) : Type(name, settings) {
-    
+
+    interned_ = true;
+
     LOG_DEBUG_LIB(LibMetkit) << "TypeEnum name=" << name << " settings=" << settings << std::endl;
 
     eckit::Value values = settings["values"];
@@ -68,6 +72,8 @@ TypeEnum::TypeEnum(const std::string& name, const eckit::Value& settings) : Type
             values_.push_back(v);
         }
     }
+    matcher_ = BestMatcher(values_, mapping_);
+
     LOG_DEBUG_LIB(LibMetkit) << "TypeEnum name=" << name 
                              << " mapping " << mapping_ 
                              << std::endl;
@@ -80,30 +86,31 @@ void TypeEnum::print(std::ostream& out) const {
 }
 
 bool TypeEnum::expand(const MarsExpandContext& ctx, std::string& value) const {
-    std::map<std::string, std::string>::iterator c = cache_.find(value);
-    if (c != cache_.end()) {
-        value = (*c).second;
-        return true;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        std::map<std::string, std::string>::const_iterator c = cache_.find(value);
+        if (c != cache_.end()) {
+            value = (*c).second;
+            return true;
+        }
     }
 
-    std::string v = MarsLanguage::bestMatch(ctx, value, values_, false, false, mapping_);
+    std::string v = matcher_.match(ctx, value, false, false);
     if (v.empty()) {
         return false;
     }
 
     std::map<std::string, std::string>::const_iterator k = mapping_.find(v);
     ASSERT(k != mapping_.end());
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (cache_.size() >= cacheSize) {
+        cache_.clear();
+    }
     value = cache_[value] = (*k).second;
 
     return true;
 }
 
-
-void TypeEnum::reset() {
-    // cache_.clear();
-    Type::reset();
-}
-
 static TypeBuilder<TypeEnum> type("enum");
 
 //----------------------------------------------------------------------------------------------------------------------
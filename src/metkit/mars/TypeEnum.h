@@ -16,6 +16,9 @@
 #ifndef metkit_TypeEnum_H
 #define metkit_TypeEnum_H
 
+#include <shared_mutex>
+
+#include "metkit/mars/BestMatcher.h"
 #include "metkit/mars/Type.h"
 
 namespace metkit {
@@ -35,13 +38,15 @@ public: // methods
 private: // methods
 
     virtual void print( std::ostream &out ) const override;
-    virtual void reset() override;
     virtual bool expand(const MarsExpandContext& ctx, std::string& value) const override;
 
     std::map<std::string, std::string> mapping_;
     std::vector<std::string> values_;
+    BestMatcher matcher_;
 
+    /// Values as given and as expanded, shared by all threads; cleared when full
     mutable std::map<std::string, std::string> cache_;
+    mutable std::shared_mutex mutex_;
 
 };
 
@@ -8,8 +8,6 @@
  * does it submit to any jurisdiction.
  */
 
-#include <iomanip>
-
 #include "eckit/utils/Translator.h"
 #include "eckit/utils/StringTools.h"
 
@@ -28,9 +26,11 @@ TypeExpver::TypeExpver(const std::string& name, const eckit::Value& settings) :
 TypeExpver::~TypeExpver() {}
 
 bool TypeExpver::expand(const MarsExpandContext&, std::string& value) const {
-    std::ostringstream oss;
-    oss << std::setfill('0') << std::setw(4) << eckit::StringTools::trim(value);
-    value = oss.str();
+    // Same as printing with setfill('0') and setw(4), without a stream
+    value = eckit::StringTools::trim(value);
+    if (value.size() < 4) {
+        value.insert(0, 4 - value.size(), '0');
+    }
     return true;
 }
 
@@ -31,10 +31,13 @@ public: // methods
 
     virtual ~TypeFloat() override;
 
+protected: // methods
+
+    virtual bool expand(const MarsExpandContext& ctx, std::string& value) const override;
+
 private: // methods
 
     virtual void print( std::ostream &out ) const override;
-    virtual bool expand(const MarsExpandContext& ctx, std::string& value) const override;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -8,27 +8,32 @@
  * does it submit to any jurisdiction.
  */
 
+#include <memory>
+#include <shared_mutex>
+#include <unordered_map>
 
 #include "eckit/config/Resource.h"
 #include "eckit/log/Log.h"
 #include "eckit/utils/StringTools.h"
-#include "eckit/parser/YAMLParser.h"
-#include "eckit/thread/AutoLock.h"
 #include "eckit/types/Types.h"
 
+#include "metkit/mars/BestMatcher.h"
+#include "metkit/mars/Bitset.h"
+#include "metkit/mars/Keyword.h"
 #include "metkit/mars/MarsLanguage.h"
 #include "metkit/config/LibMetkit.h"
 #include "metkit/mars/TypeParam.h"
 #include "metkit/mars/TypesFactory.h"
+#include "metkit/mars/YAMLCache.h"
 
 #include "metkit/mars/MarsExpandContext.h"
 
 using eckit::Log;
 using metkit::LibMetkit;
+using metkit::mars::Bitset;
 
 namespace {
 
-static eckit::Mutex *local_mutex = 0;
 static pthread_once_t once = PTHREAD_ONCE_INIT;
 
 
@@ -42,7 +47,8 @@ public:
     Matcher(const std::string& name,
             const eckit::Value values);
 
-    bool match(const metkit::mars::MarsRequest& request, bool partial=false) const ;
+    const std::string& name() const { return name_; }
+    const eckit::Value& values() const { return values_; }
 
     friend std::ostream& operator<<(std::ostream& out, const Matcher& matcher) {
         out << matcher.name_ << "=" << matcher.values_;
@@ -61,39 +67,27 @@ Matcher::Matcher(const std::string& name,
 
 }
 
-bool Matcher::match(const metkit::mars::MarsRequest& request, bool partial) const {
-
-    std::vector<std::string> vals = request.values(name_, true);
-    if (vals.size() == 0) {
-        return partial;
-    }
-
-    // std::cout << vals << std::endl;
-
-
-    for (size_t i = 0; i < values_.size(); i++) {
-        std::string v = values_[i];
-
-        if (v == vals[0]) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
 //----------------------------------------------------------------------------------------------------------------------
 
 class Rule : public metkit::mars::MarsExpandContext {
 
     std::vector<Matcher> matchers_;
-    std::vector<std::string> values_;
 
-    mutable std::map<std::string, std::string> mapping_;
+    std::map<std::string, std::string> mapping_;
+
+    /// Param ids and names of the rule, with their aliases
+    metkit::mars::BestMatcher matcher_;
+
+    /// Param ids and exact names already resolved, shared by all threads, up to cacheSize of them
+    mutable std::unordered_map<std::string, std::string> cache_;
+    mutable std::unique_ptr<std::shared_mutex> mutex_;
+
+    std::string resolve(const MarsExpandContext& ctx, const std::string & s, bool fail) const;
 
 public:
 
-    bool match(const metkit::mars::MarsRequest& request, bool partial=false) const;
+    const std::vector<Matcher>& matchers() const { return matchers_; }
+
     std::string lookup(const MarsExpandContext& ctx, const std::string & s, bool fail) const;
     long toParamid(const std::string& param) const;
 
@@ -122,9 +116,11 @@ public:
 };
 
 
-Rule::Rule(const eckit::Value& matchers, const eckit::Value& values, const eckit::Value& ids) {
+Rule::Rule(const eckit::Value& matchers, const eckit::Value& values, const eckit::Value& ids) :
+    mutex_(new std::shared_mutex()) {
 
     std::map<std::string, size_t> precedence;
+    std::vector<std::string> names;
 
     const eckit::Value& keys = matchers.keys();
     for (size_t i = 0; i < keys.size(); ++i) {
@@ -137,7 +133,7 @@ Rule::Rule(const eckit::Value& matchers, const eckit::Value& values, const eckit
         const eckit::Value& id = values[i];
 
         std::string first = id;
-        values_.push_back(first);
+        names.push_back(first);
 
         const eckit::Value& aliases = ids[id];
 
@@ -193,22 +189,15 @@ Rule::Rule(const eckit::Value& matchers, const eckit::Value& values, const eckit
             }
 
             mapping_[v] = first;
-            values_.push_back(v);
+            names.push_back(v);
         }
     }
+
+    matcher_ = metkit::mars::BestMatcher(names, mapping_);
 }
 
 
 
-bool Rule::match(const metkit::mars::MarsRequest& request, bool partial) const {
-    for (std::vector<Matcher>::const_iterator j = matchers_.begin(); j != matchers_.end(); ++j) {
-        if (!(*j).match(request, partial)) {
-            return false;
-        }
-    }
-    return true;
-}
-
 class ChainedContext : public metkit::mars::MarsExpandContext {
     const MarsExpandContext& ctx1_;
     const MarsExpandContext& ctx2_;
@@ -226,7 +215,36 @@ public:
 };
 
 
+/// Most tokens cached per rule; as TypeRegex does, the cache is emptied when full
+static const size_t cacheSize = 4096;
+
 std::string Rule::lookup(const MarsExpandContext& ctx, const std::string & s, bool fail) const {
+    {
+        std::shared_lock<std::shared_mutex> lock(*mutex_);
+        auto c = cache_.find(s);
+        if (c != cache_.end()) {
+            return (*c).second;
+        }
+    }
+
+    std::string result = resolve(ctx, s, fail);
+
+    // Only param ids and exact names are cached: resolving anything else prints a "Matching" warning, which
+    // a cache hit would skip
+    bool exact = matcher_.find(s) || s.find_first_not_of("0123456789.") == std::string::npos;
+
+    if (!result.empty() && exact) {
+        std::unique_lock<std::shared_mutex> lock(*mutex_);
+        if (cache_.size() >= cacheSize) {
+            cache_.clear();
+        }
+        cache_.emplace(s, result);
+    }
+
+    return result;
+}
+
+std::string Rule::resolve(const MarsExpandContext& ctx, const std::string & s, bool fail) const {
 
     size_t table = 0;
     size_t param = 0;
@@ -279,10 +297,8 @@ std::string Rule::lookup(const MarsExpandContext& ctx, const std::string & s, bo
         // return  metkit::mars::MarsLanguage::bestMatch(oss.str(), values_, fail, false, mapping_, this);
 
         std::string p = oss.str();
-        for (std::vector<std::string>::const_iterator j = values_.begin(); j != values_.end(); ++j) {
-            if ((*j) == p) {
-                return p;
-            }
+        if (matcher_.find(p)) {
+            return p;
         }
 
         throw eckit::UserError("Cannot match parameter " + p);
@@ -300,26 +316,120 @@ std::string Rule::lookup(const MarsExpandContext& ctx, const std::string & s, bo
 
     ChainedContext c(ctx, *this);
 
-    return metkit::mars::MarsLanguage::bestMatch(c, s, values_, fail, false, mapping_);
+    return matcher_.match(c, s, fail, false);
 }
 
-static std::vector<Rule>* rules = 0;
+//----------------------------------------------------------------------------------------------------------------------
+
+/// The rules, compiled for selection. For each keyword a matcher looks at, each value has the set of rules
+/// it lets through: those accepting the value and those not looking at the keyword. The rules matching a
+/// request are the intersection of these sets over the keywords, and the first one is the first set bit.
+/// Read-only once built, so it is shared by all threads without locking.
+
+class RuleIndex {
+
+    struct Key {
+        size_t keyword;
+        Bitset free;
+        std::unordered_map<std::string, Bitset> accepted;
+    };
+
+    std::vector<Rule> rules_;
+    std::vector<Key> keys_;
+
+public:
+
+    RuleIndex(std::vector<Rule>&& rules);
+
+    const Rule& operator[](size_t i) const { return rules_[i]; }
+
+    /// Sets the rules matching the request, i.e. the first value of each keyword is accepted by the
+    /// matchers; with partial, matchers on keywords missing from the request are ignored
+    void select(const metkit::mars::MarsRequest& request, bool partial, Bitset& result) const;
 
+    /// First rule matching the request, or null
+    const Rule* first(const metkit::mars::MarsRequest& request) const;
+};
+
+RuleIndex::RuleIndex(std::vector<Rule>&& rules) :
+    rules_(std::move(rules)) {
+
+    std::map<std::string, size_t> index;
+
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        for (const Matcher& m : rules_[i].matchers()) {
+            auto k = index.find(m.name());
+            if (k == index.end()) {
+                k = index.emplace(m.name(), keys_.size()).first;
+                keys_.push_back(Key{metkit::mars::Keyword::id(m.name()), Bitset(rules_.size(), true), {}});
+            }
+
+            Key& key = keys_[(*k).second];
+            key.free.reset(i);
+
+            const eckit::Value& values = m.values();
+            for (size_t j = 0; j < values.size(); ++j) {
+                std::string v = values[j];
+                auto a = key.accepted.find(v);
+                if (a == key.accepted.end()) {
+                    a = key.accepted.emplace(v, Bitset(rules_.size())).first;
+                }
+                a->second.set(i);
+            }
+        }
+    }
+
+    for (Key& key : keys_) {
+        for (auto& a : key.accepted) {
+            a.second |= key.free;
+        }
+    }
 }
 
-static void init() {
+void RuleIndex::select(const metkit::mars::MarsRequest& request, bool partial, Bitset& result) const {
+    result.resize(rules_.size());
+    result.set();
+
+    for (const Key& key : keys_) {
+        const metkit::mars::Parameter* p = request.parameter(key.keyword);
+        if (!p || p->values().empty()) {
+            if (!partial) {
+                result &= key.free;
+            }
+        }
+        else {
+            auto a = key.accepted.find(p->values()[0]);
+            result &= (a == key.accepted.end()) ? key.free : a->second;
+        }
+
+        if (result.none()) {
+            break;
+        }
+    }
+}
+
+const Rule* RuleIndex::first(const metkit::mars::MarsRequest& request) const {
+    Bitset selected;
+    select(request, false, selected);
 
-    local_mutex = new eckit::Mutex();
-    rules = new std::vector<Rule>();
+    size_t i = selected.next(0);
+    return i < rules_.size() ? &rules_[i] : nullptr;
+}
+
+static RuleIndex* rules = 0;
+
+}
+
+static void init() {
 
-    const eckit::Value ids = eckit::YAMLParser::decodeFile(LibMetkit::paramIDYamlFile());
+    const eckit::Value ids = metkit::mars::YAMLCache::decodeFile(LibMetkit::paramIDYamlFile());
     ASSERT(ids.isOrderedMap());
 
-    eckit::Value r = eckit::YAMLParser::decodeFile(LibMetkit::paramYamlFile());
+    eckit::Value r = metkit::mars::YAMLCache::decodeFile(LibMetkit::paramYamlFile());
     ASSERT(r.isList());
     // r.dump(std::cout) << std::endl;
 
-    const eckit::Value rs = eckit::YAMLParser::decodeFile(LibMetkit::paramStaticYamlFile());
+    const eckit::Value rs = metkit::mars::YAMLCache::decodeFile(LibMetkit::paramStaticYamlFile());
     ASSERT(rs.isList());
 
     // merge r and rs
@@ -354,9 +464,12 @@ static void init() {
         }
     }
 
+    std::vector<Rule> all;
     for (auto it = merge.begin(); it != merge.end(); it++) {
-        (*rules).push_back(Rule(it->first, it->second, ids));
+        all.push_back(Rule(it->first, it->second, ids));
     }
+
+    rules = new RuleIndex(std::move(all));
 }
 
 
@@ -391,17 +504,8 @@ void TypeParam::print(std::ostream &out) const {
 bool TypeParam::expand(const MarsExpandContext& ctx, const MarsRequest& request, std::vector<std::string>& values, bool fail) const {
 
     pthread_once(&once, init);
-    eckit::AutoLock<eckit::Mutex> lock(local_mutex);
-
-    const Rule* rule = 0;
-
-    for (std::vector<Rule>::const_iterator j = rules->begin(); j != rules->end(); ++j) {
-        if ((*j).match(request)) {
-            rule = &(*j);
-            break;
-        }
-    }
 
+    const Rule* rule = rules->first(request);
 
     if (!rule) {
 
@@ -409,19 +513,18 @@ bool TypeParam::expand(const MarsExpandContext& ctx, const MarsRequest& request,
 
 
         if (firstRule_) {
-            bool found = false;
-            for (std::vector<Rule>::const_iterator j = rules->begin(); j != rules->end() && !rule ; ++j) {
-                const Rule* r = &(*j);
-                if ((*j).match(request, true)) {
-                    for (std::vector<std::string>::iterator j = values.begin(); j != values.end() && !rule; ++j) {
-                        std::string& s = (*j);
-                        try {
-                            s = r->lookup(ctx, s, fail);
-                            rule = r;
-                            Log::warning() << "TypeParam: using 'first matching rule' option " << *rule << std::endl;
-                        } catch (...) {
-
-                        }
+            Bitset partial;
+            rules->select(request, true, partial);
+            for (size_t i = partial.next(0); i < partial.size() && !rule; i = partial.next(i + 1)) {
+                const Rule* r = &(*rules)[i];
+                for (std::vector<std::string>::iterator j = values.begin(); j != values.end() && !rule; ++j) {
+                    std::string& s = (*j);
+                    try {
+                        s = r->lookup(ctx, s, fail);
+                        rule = r;
+                        Log::warning() << "TypeParam: using 'first matching rule' option " << *rule << std::endl;
+                    } catch (...) {
+
                     }
                 }
             }
@@ -433,12 +536,9 @@ bool TypeParam::expand(const MarsExpandContext& ctx, const MarsRequest& request,
                     tmp.setValue((*j).first, (*j).second);
                 }
             }
-            for (std::vector<Rule>::const_iterator j = rules->begin(); j != rules->end(); ++j) {
-                if ((*j).match(tmp)) {
-                    rule = &(*j);
-                    Log::warning() << "TypeParam using 'expand with' option " << *rule << std::endl;
-                    break;
-                }
+            rule = rules->first(tmp);
+            if (rule) {
+                Log::warning() << "TypeParam using 'expand with' option " << *rule << std::endl;
             }
 
         }
@@ -465,7 +565,7 @@ bool TypeParam::expand(const MarsExpandContext& ctx, const MarsRequest& request,
 }
 
 
-void TypeParam::pass2(const MarsExpandContext& ctx, MarsRequest& request) {
+void TypeParam::pass2(const MarsExpandContext& ctx, MarsRequest& request) const {
     // std::cout << request << std::endl;
     std::vector<std::string> values = request.values(name_, true);
     expand(ctx, request, values, true);
@@ -477,11 +577,6 @@ void TypeParam::expand(const MarsExpandContext& ctx, std::vector<std::string>& v
 // Work done on pass2()
 }
 
-void TypeParam::reset() {
-    // cache_.clear();
-    Type::reset();
-}
-
 static TypeBuilder<TypeParam> type("param");
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -41,8 +41,7 @@ private: // methods
     bool firstRule_;
 
     virtual void print(std::ostream &out) const override;
-    virtual void reset() override;
-    virtual void pass2(const MarsExpandContext& ctx, MarsRequest& request) override;
+    virtual void pass2(const MarsExpandContext& ctx, MarsRequest& request) const override;
     virtual void expand(const MarsExpandContext& ctx,
                         std::vector<std::string>& values) const override;
 };
@@ -21,6 +21,8 @@ namespace mars {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+static const size_t cacheSize = 4096;
+
 TypeRegex::TypeRegex(const std::string &name, const eckit::Value& settings) :
     Type(name, settings),
     uppercase_(false) {
@@ -44,21 +46,42 @@ TypeRegex::TypeRegex(const std::string &name, const eckit::Value& settings) :
 TypeRegex::~TypeRegex() {
 }
 
-bool TypeRegex::expand(const MarsExpandContext& ctx, std::string& value) const {
-    for (std::vector<eckit::Regex>::const_iterator j = regex_.begin(); j != regex_.end(); ++j) {
+bool TypeRegex::match(const std::string& value) const {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        auto c = cache_.find(value);
+        if (c != cache_.end()) {
+            return (*c).second;
+        }
+    }
+
+    bool result = false;
+    for (const eckit::Regex& regex : regex_) {
+        if (regex.match(value)) {
+            result = true;
+            break;
+        }
+    }
 
-        if ((*j).match(value)) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (cache_.size() >= cacheSize) {
+        cache_.clear();
+    }
+    cache_.emplace(value, result);
 
-            if (uppercase_) {
-                value = eckit::StringTools::upper(value);
-            }
+    return result;
+}
 
-            return true;
-        }
+bool TypeRegex::expand(const MarsExpandContext& ctx, std::string& value) const {
+    if (!match(value)) {
+        return false;
     }
 
-    return false;
+    if (uppercase_) {
+        value = eckit::StringTools::upper(value);
+    }
 
+    return true;
 }
 
 
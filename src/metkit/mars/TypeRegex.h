@@ -16,9 +16,13 @@
 #ifndef metkit_TypeRegex_H
 #define metkit_TypeRegex_H
 
-#include "metkit/mars/Type.h"
+#include <shared_mutex>
+#include <unordered_map>
+
 #include "eckit/utils/Regex.h"
 
+#include "metkit/mars/Type.h"
+
 namespace metkit {
 namespace mars {
 
@@ -38,9 +42,16 @@ private: // methods
     virtual void print( std::ostream &out ) const override;
     virtual bool expand(const MarsExpandContext& ctx, std::string& value) const override;
 
+    /// Whether one of the expressions matches, remembering the result
+    bool match(const std::string& value) const;
+
     std::vector<eckit::Regex> regex_;
     bool uppercase_;
 
+    /// Results of match(), shared by all threads; cleared when full
+    mutable std::unordered_map<std::string, bool> cache_;
+    mutable std::shared_mutex mutex_;
+
 };
 
 //----------------------------------------------------------------------------------------------------------------------
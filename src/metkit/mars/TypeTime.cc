@@ -19,6 +19,8 @@
 #include "metkit/mars/TypeTime.h"
 #include "eckit/utils/StringTools.h"
 
+#include "metkit/mars/ValueRange.h"
+
 namespace metkit {
 namespace mars {
 
@@ -26,6 +28,8 @@ namespace mars {
 
 TypeTime::TypeTime(const std::string &name, const eckit::Value& settings) :
     Type(name, settings), by_(6) {
+
+    interned_ = true;
 }
 
 TypeTime::~TypeTime() {
@@ -83,6 +87,53 @@ bool TypeTime::expand(const MarsExpandContext&, std::string &value) const {
 }
 
 
+/// A step of a range as expand() tidies it, for steps below 10000
+static std::string formatTime(long n) {
+    std::ostringstream oss;
+    oss << std::setfill('0') << std::setw(4) << (n < 100 ? n * 100 : n);
+    return oss.str();
+}
+
+ValueRange* TypeTime::range(const MarsExpandContext& ctx, const std::vector<std::string>& values) const {
+
+    static eckit::Translator<std::string, long> s2l;
+
+    // Duplicates are removed by the eager expansion
+    if (!multiple_ || !duplicates_) {
+        return nullptr;
+    }
+
+    if (values.size() != 3 && !(values.size() == 5 && eckit::StringTools::lower(values[3]) == "by")) {
+        return nullptr;
+    }
+
+    if (eckit::StringTools::lower(values[0]) == "to" || eckit::StringTools::lower(values[1]) != "to") {
+        return nullptr;
+    }
+
+    std::string first = values[0];
+    if (!expand(ctx, first)) {
+        return nullptr;
+    }
+
+    long from = s2l(first);
+    long to   = s2l(tidy(ctx, values[2]));
+    long by   = values.size() == 5 ? s2l(tidy(ctx, values[4])) : by_;
+
+    if (by <= 0 || from < 0 || to < from || to >= 10000) {
+        return nullptr;
+    }
+
+    // Steps below 100 are read as hours, so 6 and 600 are the same time: leave those to check()
+    for (long n = from; n < 100 && n <= to; n += by) {
+        if (n > 0 && n * 100 <= to && (n * 100 - from) % by == 0) {
+            return nullptr;
+        }
+    }
+
+    return new ValueRange(first, from, to, by, formatTime);
+}
+
 void TypeTime::expand(const MarsExpandContext& ctx, std::vector<std::string>& values) const {
 
     static eckit::Translator<std::string, long> s2l;
@@ -92,7 +143,7 @@ void TypeTime::expand(const MarsExpandContext& ctx, std::vector<std::string>& va
 
     for (size_t i = 0; i < values.size(); ++i) {
 
-        const std::string& s = values[i];
+        std::string& s = values[i];
 
         if (eckit::StringTools::lower(s) == "to") {
             ASSERT(newval.size() > 0);
@@ -115,7 +166,7 @@ void TypeTime::expand(const MarsExpandContext& ctx, std::vector<std::string>& va
 
         }
         else {
-            newval.push_back(s);
+            newval.push_back(std::move(s));
         }
     }
 
@@ -15,6 +15,7 @@
 #include "eckit/utils/StringTools.h"
 
 #include "metkit/mars/TypesFactory.h"
+#include "metkit/mars/ValueRange.h"
 
 namespace metkit {
 namespace mars {
@@ -37,6 +38,45 @@ void TypeToByList::print(std::ostream &out) const {
 }
 
 
+static std::string formatInteger(long n) {
+    static eckit::Translator<long, std::string> l2s;
+    return l2s(n);
+}
+
+ValueRange* TypeToByList::range(const MarsExpandContext& ctx, const std::vector<std::string>& values) const {
+
+    static eckit::Translator<std::string, long> s2l;
+
+    if (!multiple_) {
+        return nullptr;
+    }
+
+    if (values.size() != 3 && !(values.size() == 5 && eckit::StringTools::lower(values[3]) == "by")) {
+        return nullptr;
+    }
+
+    std::string to = eckit::StringTools::lower(values[1]);
+    if (to != "to" && to != "t0") {
+        return nullptr;
+    }
+
+    std::string first = values[0];
+    if (!TypeInteger::expand(ctx, first)) {
+        return nullptr;
+    }
+
+    long from = s2l(first);
+    long last = s2l(tidy(ctx, values[2]));
+    long by   = values.size() == 5 ? s2l(tidy(ctx, values[4])) : by_;
+
+    // Let expand() report invalid ranges
+    if (by <= 0 || last < from) {
+        return nullptr;
+    }
+
+    return new ValueRange(first, from, last, by, formatInteger);
+}
+
 void TypeToByList::expand(const MarsExpandContext& ctx, std::vector<std::string>& values) const {
 
     static eckit::Translator<std::string, long> s2l;
@@ -36,6 +36,7 @@ private: // methods
     virtual void print( std::ostream &out ) const override;
     virtual void expand(const MarsExpandContext& ctx,
                         std::vector<std::string>& values) const override;
+    virtual ValueRange* range(const MarsExpandContext& ctx, const std::vector<std::string>& values) const override;
 
     long by_;
 
@@ -10,11 +10,14 @@
 
 #include "TypeToByListFloat.h"
 
+#include <cmath>
+
 #include "eckit/exception/Exceptions.h"
 #include "eckit/utils/Translator.h"
 #include "eckit/utils/StringTools.h"
 
 #include "metkit/mars/TypesFactory.h"
+#include "metkit/mars/ValueRange.h"
 
 namespace metkit {
 namespace mars {
@@ -37,6 +40,50 @@ void TypeToByListFloat::print(std::ostream &out) const {
 }
 
 
+static std::string formatInteger(long n) {
+    static eckit::Translator<long, std::string> l2s;
+    return l2s(n);
+}
+
+/// Whole numbers printed without exponent, for which stepping in float is exact
+static bool whole(float x) {
+    return x == std::floor(x) && std::fabs(x) < 1e6;
+}
+
+ValueRange* TypeToByListFloat::range(const MarsExpandContext& ctx, const std::vector<std::string>& values) const {
+
+    static eckit::Translator<std::string, float> s2f;
+
+    if (!multiple_) {
+        return nullptr;
+    }
+
+    if (values.size() != 3 && !(values.size() == 5 && eckit::StringTools::lower(values[3]) == "by")) {
+        return nullptr;
+    }
+
+    std::string to = eckit::StringTools::lower(values[1]);
+    if (to != "to" && to != "t0") {
+        return nullptr;
+    }
+
+    std::string first = values[0];
+    if (!TypeFloat::expand(ctx, first)) {
+        return nullptr;
+    }
+
+    float from = s2f(first);
+    float last = s2f(tidy(ctx, values[2]));
+    float by   = values.size() == 5 ? s2f(tidy(ctx, values[4])) : by_;
+
+    // Fractional steps accumulate rounding errors that expand() reproduces, so they are expanded
+    if (!whole(from) || !whole(last) || !whole(by) || by <= 0 || last < from) {
+        return nullptr;
+    }
+
+    return new ValueRange(first, long(from), long(last), long(by), formatInteger);
+}
+
 void TypeToByListFloat::expand(const MarsExpandContext& ctx, std::vector<std::string>& values) const {
 
     static eckit::Translator<std::string, float> s2l;
@@ -0,0 +1,55 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <functional>
+
+#include "eckit/exception/Exceptions.h"
+
+#include "metkit/mars/ValueRange.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ValueRange::ValueRange(const std::string& first, long from, long to, long by, Format format) :
+    first_(first), from_(from), by_(by), size_(0), format_(format) {
+    ASSERT(by > 0);
+    ASSERT(from <= to);
+    size_ = (to - from) / by + 1;
+}
+
+const std::vector<std::string>& ValueRange::list() const {
+    std::call_once(once_, [this] {
+        list_.reserve(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            list_.push_back((*this)[i]);
+        }
+    });
+    return list_;
+}
+
+bool ValueRange::operator==(const ValueRange& other) const {
+    return first_ == other.first_ && from_ == other.from_ && by_ == other.by_ && size_ == other.size_ &&
+           format_ == other.format_;
+}
+
+uint64_t ValueRange::hash() const {
+    uint64_t h = std::hash<std::string>()(first_);
+    for (uint64_t v : {uint64_t(from_), uint64_t(by_), uint64_t(size_)}) {
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
@@ -0,0 +1,71 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   ValueRange.h
+/// @date   Oct 2026
+
+#ifndef metkit_ValueRange_H
+#define metkit_ValueRange_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "eckit/memory/Counted.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Values given as from/to/by, kept symbolic: the progression from, from + by, ... up to to, and the rule
+/// formatting each step as the type would have tidied it. Types build one in Type::range() instead of
+/// expanding the list, so that the values can be counted and flattened without making the strings.
+///
+/// The strings are made on the first call to list(), once, and shared by all the Parameters holding the
+/// range. The first value is kept as given (tidied), as it may be spelt differently from its format.
+
+class ValueRange : public eckit::Counted {
+public:  // types
+    typedef std::string (*Format)(long);
+
+public:  // methods
+    ValueRange(const std::string& first, long from, long to, long by, Format format);
+
+    size_t size() const { return size_; }
+
+    std::string operator[](size_t i) const { return i == 0 ? first_ : format_(from_ + long(i) * by_); }
+
+    /// All the values, materialised on first use
+    const std::vector<std::string>& list() const;
+
+    bool operator==(const ValueRange& other) const;
+
+    /// Hash of the progression, consistent with operator==
+    uint64_t hash() const;
+
+private:  // members
+    std::string first_;
+    long from_;
+    long by_;
+    size_t size_;
+    Format format_;
+
+    mutable std::vector<std::string> list_;
+    mutable std::once_flag once_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
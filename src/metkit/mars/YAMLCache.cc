@@ -0,0 +1,442 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <sstream>
+
+#include "eckit/config/Resource.h"
+#include "eckit/exception/Exceptions.h"
+#include "eckit/log/Log.h"
+#include "eckit/parser/YAMLParser.h"
+
+#include "metkit/config/LibMetkit.h"
+#include "metkit/mars/YAMLCache.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+// Bumped whenever the layout changes. Integers are written in native byte order, so a cache written on a
+// machine of the other endianness is seen as another version.
+const char magic[4]    = {'M', 'K', 'Y', 'C'};
+const uint32_t version = 2;
+
+enum Tag : char
+{
+    tagNil        = 'n',
+    tagBool       = 'b',
+    tagNumber     = 'i',
+    tagDouble     = 'd',
+    tagString     = 's',
+    tagList       = 'l',
+    tagMap        = 'm',
+    tagOrderedMap = 'o',
+};
+
+/// Read-only mapping of a whole file, empty if the file cannot be opened
+class MappedFile {
+public:
+    explicit MappedFile(const eckit::PathName& path) : data_(nullptr), length_(0) {
+        int fd = ::open(path.localPath(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_   = p;
+                length_ = st.st_size;
+            }
+        }
+
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data_) {
+            ::munmap(data_, length_);
+        }
+    }
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return static_cast<const char*>(data_); }
+    size_t length() const { return length_; }
+
+private:
+    void* data_;
+    size_t length_;
+};
+
+/// FNV-1a
+uint64_t hash(const char* p, size_t length) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; ++i) {
+        h = (h ^ uint8_t(p[i])) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+/// Whether stamps include a hash of the contents
+bool hashed() {
+    static bool hashed = eckit::Resource<bool>("metkitYAMLCacheHash;$METKIT_YAML_CACHE_HASH", false);
+    return hashed;
+}
+
+/// What the cache was built from. The contents are only hashed on request: it reads the whole file, which is
+/// only needed where modification times are coarse, or restored by the tool that wrote the file.
+struct Stamp {
+    uint64_t size     = 0;
+    int64_t modified  = 0;
+    uint64_t contents = 0;
+    std::string path;
+
+    Stamp() = default;
+    explicit Stamp(const eckit::PathName& yaml) : path(yaml.asString()) {
+        struct stat st;
+        if (::stat(yaml.localPath(), &st) != 0) {
+            throw eckit::FailedSystemCall("stat " + path);
+        }
+        size     = st.st_size;
+#ifdef __APPLE__
+        modified = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+        modified = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+
+        if (hashed()) {
+            MappedFile file(yaml);
+            contents = hash(file.data(), file.length());
+        }
+    }
+
+    bool operator==(const Stamp& other) const {
+        return size == other.size && modified == other.modified && contents == other.contents &&
+               path == other.path;
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Writer {
+public:
+    template <class T>
+    void put(T v) {
+        out_.append(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+
+    void putString(const std::string& s) {
+        put(uint32_t(s.size()));
+        out_.append(s);
+    }
+
+    void putStamp(const Stamp& stamp) {
+        out_.append(magic, sizeof(magic));
+        put(version);
+        put(stamp.size);
+        put(stamp.modified);
+        put(stamp.contents);
+        putString(stamp.path);
+    }
+
+    void putValue(const eckit::Value& v) {
+        if (v.isNil()) {
+            put(char(tagNil));
+        }
+        else if (v.isBool()) {
+            put(char(tagBool));
+            put(char(bool(v)));
+        }
+        else if (v.isNumber()) {
+            put(char(tagNumber));
+            put(int64_t(static_cast<long long>(v)));
+        }
+        else if (v.isDouble()) {
+            put(char(tagDouble));
+            put(double(v));
+        }
+        else if (v.isString()) {
+            put(char(tagString));
+            putString(v);
+        }
+        else if (v.isList()) {
+            put(char(tagList));
+            put(uint32_t(v.size()));
+            for (size_t i = 0; i < v.size(); ++i) {
+                putValue(v[i]);
+            }
+        }
+        else if (v.isOrderedMap() || v.isMap()) {
+            put(char(v.isOrderedMap() ? tagOrderedMap : tagMap));
+            eckit::Value keys = v.keys();
+            put(uint32_t(keys.size()));
+            for (size_t i = 0; i < keys.size(); ++i) {
+                putValue(keys[i]);
+                putValue(v[keys[i]]);
+            }
+        }
+        else {
+            std::ostringstream oss;
+            oss << "YAMLCache: cannot encode " << v;
+            throw eckit::BadValue(oss.str());
+        }
+    }
+
+    const std::string& str() const { return out_; }
+
+private:
+    std::string out_;
+};
+
+class Reader {
+public:
+    Reader(const char* p, size_t length) : p_(p), end_(p + length) {}
+
+    template <class T>
+    T get() {
+        check(sizeof(T));
+        T v;
+        std::memcpy(&v, p_, sizeof(T));
+        p_ += sizeof(T);
+        return v;
+    }
+
+    std::string getString() {
+        size_t len = get<uint32_t>();
+        check(len);
+        std::string s(p_, len);
+        p_ += len;
+        return s;
+    }
+
+    /// Reads the header, returning false if it is not one of this version
+    bool getStamp(Stamp& stamp) {
+        if (size_t(end_ - p_) < sizeof(magic) || std::memcmp(p_, magic, sizeof(magic)) != 0) {
+            return false;
+        }
+        p_ += sizeof(magic);
+        if (get<uint32_t>() != version) {
+            return false;
+        }
+        stamp.size     = get<uint64_t>();
+        stamp.modified = get<int64_t>();
+        stamp.contents = get<uint64_t>();
+        stamp.path     = getString();
+        return true;
+    }
+
+    eckit::Value getValue() {
+        char tag = get<char>();
+        switch (tag) {
+            case tagNil:
+                return eckit::Value();
+
+            case tagBool:
+                return eckit::Value(get<char>() != 0);
+
+            case tagNumber:
+                return eckit::Value(static_cast<long long>(get<int64_t>()));
+
+            case tagDouble:
+                return eckit::Value(get<double>());
+
+            case tagString:
+                return eckit::Value(getString());
+
+            case tagList: {
+                size_t n = get<uint32_t>();
+                // Each element takes at least its tag, so a damaged count does not reserve more than the file holds
+                check(n);
+                eckit::ValueList list;
+                list.reserve(n);
+                for (size_t i = 0; i < n; ++i) {
+                    list.push_back(getValue());
+                }
+                return eckit::Value(list);
+            }
+
+            case tagMap:
+            case tagOrderedMap: {
+                size_t n = get<uint32_t>();
+                check(2 * n);
+                eckit::Value map = tag == tagOrderedMap ? eckit::Value::makeOrderedMap() : eckit::Value::makeMap();
+                for (size_t i = 0; i < n; ++i) {
+                    eckit::Value key = getValue();
+                    map[key]         = getValue();
+                }
+                return map;
+            }
+
+            default:
+                throw eckit::BadValue("YAMLCache: invalid tag");
+        }
+    }
+
+    bool atEnd() const { return p_ == end_; }
+
+private:
+    void check(size_t n) const {
+        if (size_t(end_ - p_) < n) {
+            throw eckit::BadValue("YAMLCache: truncated cache");
+        }
+    }
+
+    const char* p_;
+    const char* end_;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// $METKIT_CACHE_DIR, else $XDG_CACHE_HOME/metkit, else ~/.cache/metkit; empty if there is no home directory
+const std::string& directory() {
+    static std::string dir = []() {
+        std::string d = eckit::Resource<std::string>("metkitCacheDir;$METKIT_CACHE_DIR", "");
+        if (d.empty()) {
+            const char* xdg  = ::getenv("XDG_CACHE_HOME");
+            const char* home = ::getenv("HOME");
+            if (xdg && *xdg) {
+                d = std::string(xdg) + "/metkit";
+            }
+            else if (home && *home) {
+                d = std::string(home) + "/.cache/metkit";
+            }
+        }
+        return d;
+    }();
+    return dir;
+}
+
+bool enabled() {
+    static bool enabled = eckit::Resource<bool>("metkitYAMLCache;$METKIT_YAML_CACHE", true) && !directory().empty();
+    return enabled;
+}
+
+}  // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+eckit::PathName YAMLCache::cacheFile(const eckit::PathName& yaml) {
+    // Files of the same name in different places (e.g. two installations) get caches of their own
+    std::string path = yaml.asString();
+    std::ostringstream name;
+    name << yaml.baseName().asString() << "." << std::hex << hash(path.data(), path.size()) << ".cache";
+    return eckit::PathName(directory() + "/" + name.str());
+}
+
+eckit::Value YAMLCache::decodeFile(const eckit::PathName& yaml) {
+    if (!enabled()) {
+        return eckit::YAMLParser::decodeFile(yaml);
+    }
+
+    eckit::PathName cache = cacheFile(yaml);
+    MappedFile file(cache);
+
+    if (file.data()) {
+        try {
+            Reader reader(file.data(), file.length());
+            Stamp stamp;
+            if (reader.getStamp(stamp) && stamp == Stamp(yaml)) {
+                eckit::Value value = reader.getValue();
+                if (reader.atEnd()) {
+                    LOG_DEBUG_LIB(LibMetkit) << "YAMLCache: " << yaml << " loaded from " << cache << std::endl;
+                    return value;
+                }
+            }
+            LOG_DEBUG_LIB(LibMetkit) << "YAMLCache: " << cache << " is stale" << std::endl;
+        }
+        catch (const std::exception& e) {
+            // Whatever is wrong with the cache, the YAML file is still there
+            LOG_DEBUG_LIB(LibMetkit) << "YAMLCache: ignoring " << cache << ": " << e.what() << std::endl;
+        }
+    }
+
+    return update(yaml);
+}
+
+eckit::Value YAMLCache::update(const eckit::PathName& yaml) {
+    Stamp stamp(yaml);
+    eckit::Value value = eckit::YAMLParser::decodeFile(yaml);
+
+    if (!enabled()) {
+        return value;
+    }
+
+    eckit::PathName cache = cacheFile(yaml);
+
+    try {
+        eckit::PathName(directory()).mkdir();
+
+        Writer writer;
+        writer.putStamp(stamp);
+        writer.putValue(value);
+
+        // Write aside and rename, so that concurrent readers never see a partial cache
+        std::string tmp = std::string(cache.localPath()) + "." + std::to_string(::getpid());
+        {
+            std::ofstream out(tmp.c_str(), std::ios::binary);
+            out.write(writer.str().data(), writer.str().size());
+            out.close();
+            if (!out) {
+                ::unlink(tmp.c_str());
+                LOG_DEBUG_LIB(LibMetkit) << "YAMLCache: cannot write " << tmp << std::endl;
+                return value;
+            }
+        }
+
+        if (::rename(tmp.c_str(), cache.localPath()) != 0) {
+            ::unlink(tmp.c_str());
+            LOG_DEBUG_LIB(LibMetkit) << "YAMLCache: cannot rename " << tmp << " to " << cache << std::endl;
+            return value;
+        }
+
+        LOG_DEBUG_LIB(LibMetkit) << "YAMLCache: " << yaml << " cached in " << cache << std::endl;
+    }
+    catch (const std::exception& e) {
+        LOG_DEBUG_LIB(LibMetkit) << "YAMLCache: cannot cache " << yaml << ": " << e.what() << std::endl;
+    }
+
+    return value;
+}
+
+std::string YAMLCache::encode(const eckit::Value& value) {
+    Writer writer;
+    writer.putValue(value);
+    return writer.str();
+}
+
+eckit::Value YAMLCache::decode(const char* buffer, size_t length) {
+    Reader reader(buffer, length);
+    eckit::Value value = reader.getValue();
+    if (!reader.atEnd()) {
+        throw eckit::BadValue("YAMLCache: trailing bytes after value");
+    }
+    return value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
@@ -0,0 +1,66 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation nor
+ * does it submit to any jurisdiction.
+ */
+
+/// @file   YAMLCache.h
+/// @date   Oct 2026
+
+#ifndef metkit_YAMLCache_H
+#define metkit_YAMLCache_H
+
+#include <cstddef>
+#include <string>
+
+#include "eckit/filesystem/PathName.h"
+#include "eckit/value/Value.h"
+
+namespace metkit {
+namespace mars {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// Binary cache of the YAML configuration files (language, param tables...), so that short-lived processes do not
+/// pay for parsing them.
+///
+/// decodeFile() returns the same value as eckit::YAMLParser::decodeFile(). The first time a file is read, its
+/// value is saved in a binary file of the user's cache directory ($METKIT_CACHE_DIR, else $XDG_CACHE_HOME/metkit,
+/// else ~/.cache/metkit), which later calls map in memory and decode. Nothing is written next to the YAML files,
+/// which are usually installed read-only.
+///
+/// The cache records the size and modification time (to the nanosecond) of the YAML file and is ignored, then
+/// rewritten, when they no longer match or when it was written with another format version. With
+/// METKIT_YAML_CACHE_HASH=1, it also records a hash of the contents, for file systems whose times are too coarse
+/// to tell edits apart; this reads the whole YAML file on every start.
+///
+/// Caching is disabled with METKIT_YAML_CACHE=0, or when there is no home directory. Failing to write the cache
+/// is not an error, and a cache that cannot be decoded is ignored.
+
+class YAMLCache {
+public:  // methods
+    static eckit::Value decodeFile(const eckit::PathName& yaml);
+
+    /// Path of the cache of a YAML file
+    static eckit::PathName cacheFile(const eckit::PathName& yaml);
+
+    /// Parses the YAML file and (re)writes its cache
+    static eckit::Value update(const eckit::PathName& yaml);
+
+    /// Encodes a value, without header
+    static std::string encode(const eckit::Value&);
+
+    /// Decodes a value written by encode()
+    static eckit::Value decode(const char* buffer, size_t length);
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+}  // namespace mars
+}  // namespace metkit
+
+#endif
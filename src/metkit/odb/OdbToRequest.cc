@@ -70,6 +70,10 @@ std::vector<MarsRequest> OdbToRequest::odbToRequest(DataHandle& dh) const {
 
     std::vector<MarsRequest> requests;
 
+    // With one_, frames are merged into the first request in batches, to bound memory use
+    std::vector<MarsRequest> pending;
+    const size_t batch = 1024;
+
     while ( (frame = reader.next() )) {
         Span span = frame.span(OdbMetadataDecoder::columnNames(), onlyConstantColumns_);
 
@@ -79,12 +83,21 @@ std::vector<MarsRequest> OdbToRequest::odbToRequest(DataHandle& dh) const {
         span.visit(decoder);
 
         if (one_ and requests.size()) {
-            requests.back().merge(r);
+            pending.push_back(std::move(r));
+            if (pending.size() == batch) {
+                requests.back().mergeAll(pending);
+                pending.clear();
+            }
         }
         else {
-            requests.push_back(r);
+            requests.push_back(std::move(r));
         }
     }
+
+    if (pending.size()) {
+        requests.back().mergeAll(pending);
+    }
+
     return requests;
 }
 
@@ -9,7 +9,6 @@
  */
 
 #include <algorithm>
-#include <fstream>
 
 #include "eckit/io/Buffer.h"
 #include "eckit/io/Offset.h"
@@ -115,8 +114,7 @@ void ParseRequest::process(const eckit::PathName& path)
         std::cout << "==========> Parsing : " << path << std::endl;
     }
 
-    std::ifstream in(path.asString().c_str());
-    MarsParser parser(in);
+    MarsBufferParser parser(path);
 
     bool inherit = true;
     MarsExpension expand(inherit);
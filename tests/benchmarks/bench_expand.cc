@@ -0,0 +1,126 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   bench_expand.cc
+/// @date   Oct 2026
+///
+/// Expanding requests with params from several threads at once: throughput should grow with the threads.
+/// Then the same with the ExpansionCache, which only has a few request shapes to keep, and the rate at which
+/// single values are matched by the types of keywords going through regular expressions or formatting.
+/// Usage: metkit_bench_expand [requests per thread] [max threads]
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "eckit/log/Timer.h"
+
+#include "metkit/mars/ExpansionCache.h"
+#include "metkit/mars/MarsExpandContext.h"
+#include "metkit/mars/MarsExpension.h"
+#include "metkit/mars/MarsLanguage.h"
+#include "metkit/mars/MarsParser.h"
+#include "metkit/mars/Type.h"
+
+using metkit::mars::DummyContext;
+using metkit::mars::ExpansionCache;
+using metkit::mars::MarsExpension;
+using metkit::mars::MarsLanguage;
+using metkit::mars::MarsParsedRequest;
+using metkit::mars::MarsParser;
+using metkit::mars::MarsRequest;
+using metkit::mars::Type;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static const std::vector<std::string> texts = {
+    "retrieve,class=od,stream=oper,type=an,levtype=pl,levelist=1000/850/500,param=t/u/v/q/z/w/r/d/vo",
+    "retrieve,class=od,stream=enfo,type=pf,number=1/to/10,levtype=sfc,param=2t/msl/tp/10u/10v/sp",
+    "retrieve,class=od,stream=wave,type=fc,levtype=sfc,step=0/to/24/by/6,param=swh/mwd/mwp",
+    "retrieve,class=od,stream=oper,type=fc,levtype=ml,levelist=1/to/10,param=130/131/132/133/152",
+};
+
+/// Values of keywords whose types use regular expressions (grid, intgrid) or formatting (expver)
+static const std::vector<std::pair<std::string, std::vector<std::string>>> values = {
+    {"grid", {"O1280", "o640", "F320", "f160"}},
+    {"intgrid", {"O1280", "o640", "N320", "auto"}},
+    {"expver", {"1", "0001", "hm1u", " 42 "}},
+};
+
+static void report(const std::string& title, size_t n, double seconds, const char* unit = "requests/s") {
+    std::cout << std::left << std::setw(40) << title << std::right << std::setw(12) << std::fixed
+              << std::setprecision(0) << (n / seconds) << " " << unit << std::endl;
+}
+
+static MarsRequest parse(const std::string& text) {
+    std::istringstream in(text);
+    MarsParser parser(in);
+    std::vector<MarsParsedRequest> v = parser.parse();
+    return v[0];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    size_t count   = argc > 1 ? std::atol(argv[1]) : 2000;
+    size_t threads = argc > 2 ? std::atol(argv[2]) : std::thread::hardware_concurrency();
+
+    std::vector<MarsRequest> requests;
+    for (const auto& text : texts) {
+        requests.push_back(parse(text));
+    }
+
+    // Load the language and param tables outside of the timings
+    MarsExpension(false).expand(requests[0]);
+
+    for (bool cached : {false, true}) {
+        ExpansionCache::instance().capacity(cached ? 1000 : 0);
+
+        for (size_t n = 1; n <= threads; n *= 2) {
+            eckit::Timer timer;
+
+            std::vector<std::thread> workers;
+            for (size_t t = 0; t < n; ++t) {
+                workers.emplace_back([&requests, count] {
+                    MarsExpension expand(false);
+                    for (size_t i = 0; i < count; ++i) {
+                        expand.expand(requests[i % requests.size()]);
+                    }
+                });
+            }
+            for (auto& w : workers) {
+                w.join();
+            }
+
+            report(std::string(cached ? "cached, " : "") + std::to_string(n) + " thread(s)", n * count,
+                   timer.elapsed());
+        }
+    }
+
+    std::cout << ExpansionCache::instance() << std::endl;
+
+    DummyContext ctx;
+    const MarsLanguage& language = MarsLanguage::instance("retrieve");
+    for (const auto& v : values) {
+        const Type* type = language.type(v.first);
+        size_t n         = 100 * count;
+
+        eckit::Timer timer;
+        for (size_t i = 0; i < n; ++i) {
+            std::string value = v.second[i % v.second.size()];
+            type->expand(ctx, value);
+        }
+        report(v.first + ", match", n, timer.elapsed(), "values/s");
+    }
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   bench_filter.cc
+/// @date   Oct 2026
+///
+/// Matching fields against many subscriptions: MarsRequest::matches against CompiledMarsFilter.
+/// Usage: metkit_bench_filter [fields] [subscriptions]
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "eckit/log/Timer.h"
+
+#include "metkit/mars/CompiledMarsFilter.h"
+#include "metkit/mars/MarsRequest.h"
+
+using metkit::mars::Bitset;
+using metkit::mars::CompiledMarsFilter;
+using metkit::mars::MarsRequest;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static const std::vector<std::string> streams = {"oper", "enfo", "wave", "waef", "scda"};
+static const std::vector<std::string> types   = {"an", "fc", "pf", "cf", "em", "es"};
+static const std::vector<std::string> levels  = {"1000", "925", "850", "700", "500", "300", "250", "200", "100", "50"};
+static const std::vector<std::string> params  = {"t", "u", "v", "q", "z", "w", "r", "d", "vo", "pv", "2t", "msl"};
+
+static std::vector<std::string> pick(std::mt19937& rng, const std::vector<std::string>& values, size_t n) {
+    std::vector<std::string> result;
+    for (size_t i = 0; i < n; ++i) {
+        result.push_back(values[rng() % values.size()]);
+    }
+    return result;
+}
+
+static MarsRequest subscription(std::mt19937& rng) {
+    MarsRequest r("retrieve");
+    r.setValue("class", "od");
+    r.values("stream", pick(rng, streams, 1));
+    r.values("type", pick(rng, types, 2));
+    r.setValue("levtype", "pl");
+    r.values("levelist", pick(rng, levels, 3));
+    r.values("param", pick(rng, params, 4));
+    return r;
+}
+
+static MarsRequest field(std::mt19937& rng) {
+    MarsRequest r("retrieve");
+    r.setValue("class", "od");
+    r.values("stream", pick(rng, streams, 1));
+    r.values("type", pick(rng, types, 1));
+    r.setValue("expver", "0001");
+    r.setValue("levtype", "pl");
+    r.values("levelist", pick(rng, levels, 1));
+    r.values("param", pick(rng, params, 1));
+    r.setValue("date", "20201016");
+    r.setValue("time", "1200");
+    r.setValue("step", long(rng() % 240));
+    return r;
+}
+
+static void report(const std::string& title, size_t n, double seconds, const char* unit = "field") {
+    std::cout << std::left << std::setw(40) << title << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << (seconds * 1e9 / n) << " ns/" << unit << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    size_t nfields        = argc > 1 ? std::atol(argv[1]) : 100000;
+    size_t nsubscriptions = argc > 2 ? std::atol(argv[2]) : 500;
+
+    std::mt19937 rng(1);
+
+    std::vector<MarsRequest> subscriptions;
+    for (size_t i = 0; i < nsubscriptions; ++i) {
+        subscriptions.push_back(subscription(rng));
+    }
+
+    std::vector<MarsRequest> fields;
+    for (size_t i = 0; i < nfields; ++i) {
+        fields.push_back(field(rng));
+    }
+
+    std::cout << nfields << " fields, " << nsubscriptions << " subscriptions" << std::endl;
+
+    size_t expected = 0;
+    {
+        eckit::Timer timer;
+        for (const auto& f : fields) {
+            for (const auto& s : subscriptions) {
+                expected += f.matches(s);
+            }
+        }
+        report("MarsRequest::matches", nfields, timer.elapsed());
+    }
+
+    size_t found = 0;
+    {
+        eckit::Timer timer;
+        CompiledMarsFilter filter(subscriptions);
+        report("CompiledMarsFilter construction", nsubscriptions, timer.elapsed(), "subscription");
+    }
+
+    CompiledMarsFilter filter(subscriptions);
+
+    {
+        eckit::Timer timer;
+        Bitset result;
+        for (const auto& f : fields) {
+            filter.matches(f, result);
+            found += result.count();
+        }
+        report("CompiledMarsFilter::matches", nfields, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        std::vector<Bitset> results;
+        filter.matches(fields, results);
+        for (const auto& r : results) {
+            found += r.count();
+        }
+        report("CompiledMarsFilter::matches, batch", nfields, timer.elapsed());
+    }
+
+    std::cout << expected << " matches, " << found / 2 << " found" << std::endl;
+
+    return (found == 2 * expected) ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   bench_finalise.cc
+/// @date   Oct 2026
+///
+/// Cost of Type::finalise, which checks the only/never rules, over all the keywords of expanded retrieve requests.
+/// Usage: metkit_bench_finalise [iterations]
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "eckit/log/Timer.h"
+
+#include "metkit/mars/MarsExpandContext.h"
+#include "metkit/mars/MarsExpension.h"
+#include "metkit/mars/MarsLanguage.h"
+#include "metkit/mars/MarsParser.h"
+#include "metkit/mars/Type.h"
+
+using metkit::mars::DummyContext;
+using metkit::mars::MarsExpension;
+using metkit::mars::MarsLanguage;
+using metkit::mars::MarsParsedRequest;
+using metkit::mars::MarsParser;
+using metkit::mars::MarsRequest;
+using metkit::mars::Type;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static const std::vector<std::string> texts = {
+    "retrieve,class=od,stream=oper,type=an,levtype=pl,levelist=1000/850/500,param=t/u/v",
+    "retrieve,class=od,stream=enfo,type=pf,number=1/to/50,levtype=sfc,param=2t/msl/tp,step=0/to/240/by/6",
+    "retrieve,class=od,stream=enfo,type=cf,levtype=pl,levelist=500,param=z,step=24",
+    "retrieve,class=od,stream=wave,type=fc,levtype=sfc,step=0/to/24/by/6,param=swh/mwd/mwp",
+};
+
+static MarsRequest parse(const std::string& text) {
+    std::istringstream in(text);
+    MarsParser parser(in);
+    std::vector<MarsParsedRequest> v = parser.parse();
+    return v[0];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::atol(argv[1]) : 100000;
+
+    const MarsLanguage& language = MarsLanguage::instance("retrieve");
+    DummyContext ctx;
+
+    std::vector<MarsRequest> requests;
+    std::vector<std::vector<const Type*>> types;
+    for (const auto& text : texts) {
+        requests.push_back(MarsExpension(false).expand(parse(text)));
+        types.emplace_back();
+        for (const std::string& p : requests.back().params()) {
+            types.back().push_back(language.type(p));
+        }
+    }
+
+    size_t calls = 0;
+    eckit::Timer timer;
+
+    // Requests come out of expansion finalised, so finalising them again leaves them unchanged
+    for (size_t i = 0; i < iterations; ++i) {
+        size_t n       = i % requests.size();
+        MarsRequest& r = requests[n];
+        for (const Type* t : types[n]) {
+            t->finalise(ctx, r, false);
+        }
+        calls += types[n].size();
+    }
+
+    double seconds = timer.elapsed();
+    std::cout << std::left << std::setw(40) << "finalise, retrieve" << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << (seconds * 1e9 / calls) << " ns/keyword, "
+              << std::setprecision(0) << (iterations / seconds) << " requests/s" << std::endl;
+
+    return 0;
+}
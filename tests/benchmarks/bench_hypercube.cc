@@ -0,0 +1,163 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   bench_hypercube.cc
+/// @date   Oct 2026
+///
+/// Checking the fields of a 10^6-field HyperCube one request at a time, against resolving them with the batch
+/// HyperCube::indexOf(); then placing them with fieldOrdinal() once the cube has holes. Last, computing the
+/// requests for the vacant fields of cubes of 10^5 to 10^7 fields with scattered holes.
+/// Usage: metkit_bench_hypercube [fields per batch]
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "eckit/log/Timer.h"
+
+#include "metkit/hypercube/HyperCube.h"
+#include "metkit/mars/MarsRequest.h"
+
+using metkit::hypercube::HyperCube;
+using metkit::mars::MarsRequest;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+/// 100 dates x 4 times x 25 steps x 10 levels x 10 params
+static const std::vector<std::string> names = {"date", "time", "step", "levelist", "param"};
+static const std::vector<size_t> sizes      = {100, 4, 25, 10, 10};
+
+static std::vector<std::string> values(size_t axis) {
+    std::vector<std::string> v;
+    for (size_t i = 0; i < sizes[axis]; ++i) {
+        v.push_back(std::to_string(axis == 0 ? 20200101 + i : 100 + i));
+    }
+    return v;
+}
+
+static std::vector<std::string> field(size_t n) {
+    std::vector<std::string> f(names.size());
+    for (size_t i = names.size(); i > 0; --i) {
+        f[i - 1] = values(i - 1)[n % sizes[i - 1]];
+        n /= sizes[i - 1];
+    }
+    return f;
+}
+
+/// The cube above, with the given number of dates
+static MarsRequest cubeRequest(size_t dates) {
+    MarsRequest request("retrieve");
+    for (size_t i = 0; i < names.size(); ++i) {
+        std::vector<std::string> v = values(i);
+        if (i == 0) {
+            v.clear();
+            for (size_t j = 0; j < dates; ++j) {
+                v.push_back(std::to_string(20200101 + j));
+            }
+        }
+        request.values(names[i], v);
+    }
+    return request;
+}
+
+static void report(const std::string& title, size_t n, double seconds) {
+    std::cout << std::left << std::setw(40) << title << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << (seconds * 1e9 / n) << " ns/field" << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    size_t batch = argc > 1 ? std::atol(argv[1]) : 100000;
+
+    HyperCube cube(cubeRequest(sizes[0]));
+    std::cout << cube.size() << " fields" << std::endl;
+
+    // A spread-out sample of fields, made outside of the timings
+    std::vector<std::vector<std::string>> fields;
+    std::vector<MarsRequest> requests;
+    for (size_t i = 0; i < batch; ++i) {
+        fields.push_back(field((i * 7919) % cube.size()));
+
+        MarsRequest r("retrieve");
+        for (size_t j = 0; j < names.size(); ++j) {
+            r.setValue(names[j], fields.back()[j]);
+        }
+        requests.push_back(r);
+    }
+
+    size_t found = 0;
+    {
+        eckit::Timer timer;
+        for (const auto& r : requests) {
+            found += cube.contains(r);
+        }
+        report("contains(MarsRequest)", batch, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        std::vector<size_t> idx = cube.indexOf(names, fields);
+        for (size_t i : idx) {
+            found -= cube.contains(i);
+        }
+        report("indexOf(names, fields) + contains", batch, timer.elapsed());
+    }
+
+    std::cout << "vacant-field bitmap: " << cube.footprint() << " bytes" << std::endl;
+
+    for (size_t i = 0; i < cube.size(); i += 13) {
+        cube.clear(i);
+    }
+
+    std::cout << "after clearing 1 field in 13: " << cube.footprint() << " bytes" << std::endl;
+
+    {
+        eckit::Timer timer;
+        size_t sum = 0;
+        for (const auto& r : requests) {
+            if (cube.contains(r)) {
+                sum += cube.fieldOrdinal(r);
+            }
+        }
+        report("fieldOrdinal", batch, timer.elapsed());
+        found += (sum == 0);
+    }
+
+    // 10^5 to 10^7 fields; holes at 1 field in 1000, then 1 in 100
+    std::mt19937_64 random(42);
+    for (size_t dates : {10, 100, 1000}) {
+        for (size_t holes : {1000, 100}) {
+            HyperCube c(cubeRequest(dates));
+            for (size_t i = 0; i < c.size(); ++i) {
+                if (random() % holes == 0) {
+                    c.clear(i);
+                }
+            }
+
+            eckit::Timer timer;
+            std::vector<MarsRequest> vacant = c.vacantRequests();
+            double seconds = timer.elapsed();
+
+            size_t covered = 0;
+            for (const auto& r : vacant) {
+                covered += HyperCube(r).size();
+            }
+            found += (covered != c.countVacant());
+
+            std::cout << "vacantRequests " << std::setw(9) << c.size() << " fields, " << std::setw(6)
+                      << (c.size() - c.countVacant()) << " holes: " << std::setw(6) << vacant.size() << " requests in "
+                      << std::fixed << std::setprecision(3) << seconds << " s" << std::endl;
+        }
+    }
+
+    return found == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   bench_parser.cc
+/// @date   Oct 2026
+///
+/// Parsing throughput of a large request file: MarsParser over a stream against MarsBufferParser over a
+/// buffer and over a memory-mapped file.
+/// Usage: metkit_bench_parser [megabytes]
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "eckit/filesystem/TmpFile.h"
+#include "eckit/log/Timer.h"
+
+#include "metkit/mars/MarsParser.h"
+
+using metkit::mars::MarsBufferParser;
+using metkit::mars::MarsParser;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static std::string requests(size_t bytes) {
+    std::ostringstream oss;
+    for (size_t i = 0; size_t(oss.tellp()) < bytes; ++i) {
+        oss << "# request " << i << "\n"
+            << "retrieve,\n"
+            << "    class    = od,\n"
+            << "    stream   = oper,\n"
+            << "    expver   = \"0001\",\n"
+            << "    type     = an,\n"
+            << "    levtype  = pl,\n"
+            << "    levelist = 1000/850/700/500/300/250/200/100,\n"
+            << "    param    = t/u/v/q/z/130.128,\n"
+            << "    date     = 20201016/to/20201031,\n"
+            << "    time     = 00/06/12/18,\n"
+            << "    grid     = 0.25/0.25,\n"
+            << "    target   = \"data/" << i << ".grib\"\n";
+    }
+    return oss.str();
+}
+
+static void report(const std::string& title, size_t bytes, size_t n, double seconds) {
+    std::cout << std::left << std::setw(40) << title << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << (bytes / seconds / (1024 * 1024)) << " MB/s, " << n << " requests"
+              << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? std::atol(argv[1]) : 10;
+
+    const std::string text = requests(megabytes * 1024 * 1024);
+
+    eckit::TmpFile file;
+    {
+        std::ofstream out(file.asString().c_str());
+        out << text;
+    }
+
+    std::cout << text.size() << " bytes" << std::endl;
+
+    size_t expected = 0;
+    {
+        eckit::Timer timer;
+        std::istringstream in(text);
+        MarsParser parser(in);
+        expected = parser.parse().size();
+        report("MarsParser, istream", text.size(), expected, timer.elapsed());
+    }
+
+    size_t found = 0;
+    {
+        eckit::Timer timer;
+        MarsBufferParser parser(text);
+        found = parser.parse().size();
+        report("MarsBufferParser, buffer", text.size(), found, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        MarsBufferParser parser(file);
+        found += parser.parse().size();
+        report("MarsBufferParser, mmap", text.size(), found / 2, timer.elapsed());
+    }
+
+    return (found == 2 * expected) ? 0 : 1;
+}
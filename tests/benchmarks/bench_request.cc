@@ -0,0 +1,314 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   bench_request.cc
+/// @date   Oct 2026
+///
+/// Micro-benchmarks of MarsRequest accessors and memory footprint.
+/// Usage: metkit_bench_request [iterations]
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <sstream>
+#include <unistd.h>
+
+#include "eckit/io/Buffer.h"
+#include "eckit/log/Bytes.h"
+#include "eckit/log/Timer.h"
+#include "eckit/serialisation/MemoryStream.h"
+#include "eckit/utils/MD5.h"
+
+#include "metkit/mars/MarsExpandContext.h"
+#include "metkit/mars/MarsExpension.h"
+#include "metkit/mars/MarsRequest.h"
+#include "metkit/mars/MarsRequestView.h"
+#include "metkit/mars/StringPool.h"
+#include "metkit/mars/TypeAny.h"
+
+using metkit::mars::MarsRequest;
+using metkit::mars::Parameter;
+using metkit::mars::TypeAny;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static const std::vector<std::string>& keywords() {
+    static std::vector<std::string> k = {"class",    "type",   "stream", "expver", "levtype", "levelist", "param",
+                                         "date",     "time",   "step",   "number", "domain",  "grid",     "area",
+                                         "resol",    "target", "padding", "accuracy", "packing", "database",
+                                         "frequency", "direction", "method", "origin", "system"};
+    return k;
+}
+
+static MarsRequest sample() {
+    MarsRequest r("retrieve");
+    for (const auto& k : keywords()) {
+        r.values(k, {k + "-1", k + "-2"});
+    }
+    return r;
+}
+
+/// Reference: the linear search over a std::list used before requests were indexed
+struct ListRequest {
+    std::list<Parameter> params_;
+
+    const std::vector<std::string>* find(const std::string& name) const {
+        for (const auto& p : params_) {
+            if (p.name() == name) {
+                return &p.values();
+            }
+        }
+        return nullptr;
+    }
+};
+
+static void report(const std::string& title, size_t n, double seconds) {
+    std::cout << std::left << std::setw(40) << title << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << (seconds * 1e9 / n) << " ns/op" << std::endl;
+}
+
+static void benchLookup(size_t iterations) {
+    const std::vector<std::string>& k = keywords();
+
+    MarsRequest r = sample();
+
+    ListRequest l;
+    for (const auto& name : k) {
+        l.params_.emplace_back(r.values(name), new TypeAny(name));
+    }
+
+    size_t n     = iterations * k.size();
+    size_t total = 0;
+
+    {
+        eckit::Timer timer;
+        for (size_t i = 0; i < iterations; ++i) {
+            for (const auto& name : k) {
+                total += l.find(name)->size();
+            }
+        }
+        report("std::list linear search", n, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        for (size_t i = 0; i < iterations; ++i) {
+            for (const auto& name : k) {
+                total += r.values(name).size();
+            }
+        }
+        report("MarsRequest::values", n, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        for (size_t i = 0; i < iterations; ++i) {
+            for (const auto& name : k) {
+                total += r.has(name);
+            }
+        }
+        report("MarsRequest::has", n, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        for (size_t i = 0; i < iterations; ++i) {
+            for (const auto& name : k) {
+                total += r.countValues(name);
+            }
+        }
+        report("MarsRequest::countValues", n, timer.elapsed());
+    }
+
+    std::cout << "checksum " << total << std::endl;
+}
+
+static void benchCopy(size_t iterations) {
+    MarsRequest r = sample();
+
+    size_t total = 0;
+    eckit::Timer timer;
+    for (size_t i = 0; i < iterations; ++i) {
+        MarsRequest c(r);
+        c.setValue("step", i);
+        total += c.countValues("step");
+    }
+    report("MarsRequest copy + setValue", iterations, timer.elapsed());
+    std::cout << "checksum " << total << std::endl;
+}
+
+static void benchDigest(size_t iterations) {
+    MarsRequest r = sample();
+
+    size_t total = 0;
+
+    {
+        eckit::Timer timer;
+        for (size_t i = 0; i < iterations; ++i) {
+            std::ostringstream oss;
+            oss << r;
+            eckit::MD5 md5(oss.str());
+            total += md5.digest().size();
+        }
+        report("md5 of the printed request", iterations, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        for (size_t i = 0; i < iterations; ++i) {
+            eckit::MD5 md5;
+            r.md5(md5);
+            total += md5.digest().size();
+        }
+        report("MarsRequest::md5", iterations, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        for (size_t i = 0; i < iterations; ++i) {
+            MarsRequest c(r);
+            c.setValue("step", long(i));
+            total += c.hash() & 1;
+        }
+        report("copy + setValue + MarsRequest::hash", iterations, timer.elapsed());
+    }
+
+    std::cout << "checksum " << total << std::endl;
+}
+
+static void benchMerge(size_t n) {
+    std::vector<MarsRequest> requests;
+    requests.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        MarsRequest r = sample();
+        r.setValue("date", long(20000101 + i));
+        r.setValue("step", long(i % 240));
+        requests.push_back(r);
+    }
+
+    size_t total = 0;
+
+    {
+        MarsRequest one = requests.front();
+        eckit::Timer timer;
+        for (const auto& r : requests) {
+            one.merge(r);
+        }
+        report("MarsRequest::merge, one at a time", n, timer.elapsed());
+        total += one.countValues("date");
+    }
+
+    {
+        MarsRequest all = requests.front();
+        eckit::Timer timer;
+        all.mergeAll(requests);
+        report("MarsRequest::mergeAll", n, timer.elapsed());
+        total += all.countValues("date");
+    }
+
+    std::cout << "checksum " << total << std::endl;
+}
+
+static void benchView(size_t n) {
+    MarsRequest r = sample();
+
+    eckit::Buffer buffer(n * 2048);
+    eckit::MemoryStream out(buffer.data(), buffer.size());
+    for (size_t i = 0; i < n; ++i) {
+        out << r;
+    }
+    size_t length = out.position();
+
+    size_t total = 0;
+
+    {
+        eckit::Timer timer;
+        eckit::MemoryStream in(buffer.data(), length);
+        for (size_t i = 0; i < n; ++i) {
+            MarsRequest d(in);
+            total += d.values("class").size() + d.values("param").size();
+        }
+        report("decode MarsRequest, read two keys", n, timer.elapsed());
+    }
+
+    {
+        eckit::Timer timer;
+        const char* p   = static_cast<const char*>(buffer.data());
+        const char* end = p + length;
+        for (size_t i = 0; i < n; ++i) {
+            metkit::mars::MarsRequestView v(p, end - p);
+            total += v.values("class").size() + v.values("param").size();
+            p += v.encodedSize();
+        }
+        report("MarsRequestView, read two keys", n, timer.elapsed());
+    }
+
+    std::cout << "checksum " << total << std::endl;
+}
+
+/// Resident set size, from /proc (Linux only, 0 elsewhere)
+static size_t residentBytes() {
+    std::ifstream in("/proc/self/statm");
+    size_t pages = 0;
+    size_t rss   = 0;
+    if (in >> pages >> rss) {
+        return rss * ::sysconf(_SC_PAGESIZE);
+    }
+    return 0;
+}
+
+class KeepAll : public metkit::mars::FlattenCallback {
+public:
+    std::vector<MarsRequest> fields_;
+
+private:
+    void operator()(const MarsRequest& r) override { fields_.push_back(r); }
+};
+
+static void benchFlattenMemory() {
+    // 7 params x 10 levels x 182 dates x 2 times x 41 steps = 1044680 fields
+    MarsRequest r = MarsRequest::parse(
+        "retrieve,class=od,stream=oper,type=fc,expver=0001,levtype=pl,"
+        "levelist=1000/925/850/700/500/400/300/250/200/100,param=t/u/v/q/z/w/r,"
+        "date=20200101/to/20200630,time=0000/1200,step=0/to/240/by/6");
+
+    size_t before = residentBytes();
+
+    KeepAll keep;
+    keep.fields_.reserve(r.count());
+
+    eckit::Timer timer;
+    metkit::mars::DummyContext ctx;
+    metkit::mars::MarsExpension expand(false);
+    expand.flatten(ctx, r, keep);
+
+    double seconds = timer.elapsed();
+    size_t after   = residentBytes();
+    size_t n       = keep.fields_.size();
+
+    std::cout << "Flattened " << n << " fields in " << seconds << "s, resident memory "
+              << eckit::Bytes(after - before) << " (" << (after - before) / n << " bytes/field), "
+              << metkit::mars::StringPool::values().size() << " pooled values" << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::atol(argv[1]) : 1000000;
+    benchLookup(iterations);
+    benchCopy(iterations / 10);
+    benchDigest(iterations / 10);
+    benchMerge(iterations / 20);
+    benchView(iterations / 100);
+    benchFlattenMemory();
+    return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   bench_startup.cc
+/// @date   Oct 2026
+///
+/// Loading the language and param tables at startup: YAML parsing against the binary cache.
+/// Usage: metkit_bench_startup [iterations]
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "eckit/log/Timer.h"
+#include "eckit/parser/YAMLParser.h"
+
+#include "metkit/config/LibMetkit.h"
+#include "metkit/mars/MarsLanguage.h"
+#include "metkit/mars/YAMLCache.h"
+
+using metkit::LibMetkit;
+using metkit::mars::MarsLanguage;
+using metkit::mars::YAMLCache;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static void report(const std::string& title, size_t n, double seconds) {
+    std::cout << std::left << std::setw(40) << title << std::right << std::setw(12) << std::fixed
+              << std::setprecision(2) << (seconds * 1e3 / n) << " ms" << std::endl;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::atol(argv[1]) : 10;
+
+    const std::vector<eckit::PathName> files = {
+        MarsLanguage::languageYamlFile(),
+        LibMetkit::paramIDYamlFile(),
+        LibMetkit::paramYamlFile(),
+        LibMetkit::paramStaticYamlFile(),
+    };
+
+    double yaml   = 0;
+    double cached = 0;
+
+    for (const auto& file : files) {
+        std::string name = file.baseName();
+
+        eckit::Value expected;
+        {
+            eckit::Timer timer;
+            for (size_t i = 0; i < iterations; ++i) {
+                expected = eckit::YAMLParser::decodeFile(file);
+            }
+            yaml += timer.elapsed() / iterations;
+            report(name + ", YAML", iterations, timer.elapsed());
+        }
+
+        {
+            eckit::Timer timer;
+            YAMLCache::update(file);
+            report(name + ", cache update", 1, timer.elapsed());
+        }
+
+        {
+            eckit::Timer timer;
+            for (size_t i = 0; i < iterations; ++i) {
+                if (YAMLCache::decodeFile(file) != expected) {
+                    std::cout << name << ": cache differs from YAML" << std::endl;
+                    return 1;
+                }
+            }
+            cached += timer.elapsed() / iterations;
+            report(name + ", cache", iterations, timer.elapsed());
+        }
+    }
+
+    report("Total, YAML", 1, yaml);
+    report("Total, cache", 1, cached);
+
+    return 0;
+}
@@ -12,12 +12,26 @@
 /// @date   Jan 2016
 /// @author Florian Rathgeber
 
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <thread>
+
+#include "eckit/parser/YAMLParser.h"
 #include "eckit/types/Date.h"
+#include "eckit/utils/Regex.h"
+#include "metkit/mars/BestMatcher.h"
+#include "metkit/mars/ExpansionCache.h"
+#include "metkit/mars/FlattenCursor.h"
+#include "metkit/mars/Keyword.h"
+#include "metkit/mars/MarsExpandContext.h"
 #include "metkit/mars/MarsRequest.h"
 #include "metkit/mars/MarsExpension.h"
 #include "metkit/mars/MarsParser.h"
 #include "metkit/mars/MarsLanguage.h"
 #include "metkit/mars/Type.h"
+#include "metkit/mars/TypeDate.h"
+#include "metkit/mars/TypeRegex.h"
 
 #include "eckit/testing/Test.h"
 
@@ -176,6 +190,456 @@ CASE( "test_metkit_expand_11_quantile" ) {
     quantile({"0:10","3:10","to","7:10","by","2","10:10"}, {"0:10","3:10","5:10","7:10","10:10"});
 }
 
+// The linear scan BestMatcher replaces, without strict mode
+static std::string linearMatch(const std::string& name, const std::vector<std::string>& values,
+                               const std::map<std::string, std::string>& aliases) {
+    auto resolve = [&aliases](const std::string& v) {
+        auto k = aliases.find(v);
+        return k == aliases.end() ? v : (*k).second;
+    };
+
+    size_t score = 1;
+    std::vector<std::string> best;
+    for (const std::string& value : values) {
+        size_t s = 0;
+        while (s < std::min(name.length(), value.length()) && ::tolower(name[s]) == ::tolower(value[s])) {
+            s++;
+        }
+        if (s == value.length() && s == name.length()) {
+            return resolve(value);
+        }
+        if (s >= score) {
+            if (s > score) {
+                best.clear();
+            }
+            best.push_back(value);
+            score = s;
+        }
+    }
+
+    if (best.size() == 1) {
+        bool numeric = std::all_of(best[0].begin(), best[0].end(), ::isdigit);
+        return (numeric && best[0] != name) ? "" : resolve(best[0]);
+    }
+
+    std::set<std::string> names;
+    for (const std::string& b : best) {
+        names.insert(resolve(b));
+    }
+    return names.size() == 1 ? resolve(best[0]) : (best.empty() ? "" : "<ambiguous>");
+}
+
+CASE( "test_metkit_best_match" ) {
+    DummyContext ctx;
+
+    std::vector<std::string> values = {"analysis", "an", "forecast", "fc", "4v", "4i", "ensemble",
+                                       "Em", "es", "129", "130", "t", "tp", "2t", "AN"};
+    std::map<std::string, std::string> aliases = {{"analysis", "an"}, {"forecast", "fc"}, {"AN", "an"}};
+
+    BestMatcher matcher(values, aliases);
+
+    EXPECT(matcher.match(ctx, "an", true, true) == "an");
+    EXPECT(matcher.match(ctx, "ANAL", true, true) == "an");
+    EXPECT(matcher.match(ctx, "fore", true, true) == "fc");
+    EXPECT(matcher.match(ctx, "em", true, true) == "Em");
+    EXPECT(matcher.match(ctx, "ensx", true, true) == "ensemble");
+    EXPECT(matcher.match(ctx, "tpx", true, true) == "tp");
+    EXPECT(matcher.match(ctx, "12", false, true) == "");
+    EXPECT(matcher.match(ctx, "x", false, true) == "");
+    EXPECT_THROWS_AS(matcher.match(ctx, "x", true, true), eckit::UserError);
+
+    try {
+        matcher.match(ctx, "4", true, true);
+        EXPECT(false);
+    }
+    catch (eckit::UserError& e) {
+        EXPECT(std::string(e.what()).find("Ambiguous value '4' could be '4v' '4i'") != std::string::npos);
+    }
+
+    // Same answers as a scan of all the values, in their order
+    std::vector<std::string> queries = {"", "a", "A", "an", "ana", "analysisx", "f", "fo", "fc", "4", "4v", "4vx",
+                                        "e", "E", "en", "es", "esx", "1", "12", "129", "1290", "13", "t", "T",
+                                        "tp", "tpx", "2", "2t", "x", "zz", "em", "EM"};
+    for (const std::string& q : queries) {
+        std::string expected = linearMatch(q, values, aliases);
+        std::string got;
+        try {
+            got = matcher.match(ctx, q, false, true);
+        }
+        catch (eckit::UserError&) {
+            got = "<ambiguous>";
+        }
+        EXPECT(got == expected);
+    }
+
+    EXPECT(MarsLanguage::bestMatch(ctx, "fore", values, true, true, aliases) == "fc");
+}
+
+static MarsRequest request(const std::string& text) {
+    std::istringstream in(text);
+    MarsParser parser(in);
+    std::vector<MarsParsedRequest> v = parser.parse();
+    ASSERT(v.size() == 1);
+    return v[0];
+}
+
+CASE( "test_metkit_expand_sessions" ) {
+    EXPECT(&MarsLanguage::instance("retrieve") == &MarsLanguage::instance("retrieve"));
+
+    MarsExpension first(true);
+    MarsExpension second(true);
+
+    first.expand(request("retrieve,date=20200101,levelist=500"));
+
+    // Inherited by the next request of the same expansion only
+    MarsRequest inherited = first.expand(request("retrieve"));
+    EXPECT(inherited.values("date") == std::vector<std::string>{"20200101"});
+    EXPECT(inherited.values("levelist") == std::vector<std::string>{"500"});
+
+    MarsRequest fresh = second.expand(request("retrieve"));
+    EXPECT(fresh.values("date") != std::vector<std::string>{"20200101"});
+    EXPECT(fresh.values("levelist").size() > 1);
+
+    first.reset();
+    EXPECT(first.expand(request("retrieve")) == fresh);
+}
+
+CASE( "test_metkit_expand_param" ) {
+    const std::string text = "retrieve,class=od,stream=oper,type=an,levtype=pl,param=";
+    const std::vector<std::string> expected = {"130", "130", "130", "131", "130"};
+
+    // The second time round, tokens come from the cache of the rule
+    for (size_t i = 0; i < 2; ++i) {
+        MarsExpension expand(false);
+        MarsRequest r = expand.expand(request(text + "t/130/130.128/u/TEMP"));
+        EXPECT(r.values("param") == expected);
+    }
+
+    MarsExpension expand(false);
+    EXPECT_THROWS_AS(expand.expand(request(text + "999999")), eckit::UserError);
+}
+
+CASE( "test_metkit_expand_only_never" ) {
+    const std::string text = "retrieve,class=od,levtype=sfc,param=2t,levelist=500,number=1/2,";
+
+    MarsExpension expand(false);
+
+    MarsRequest r = expand.expand(request(text + "stream=enfo,type=pf"));
+    EXPECT(r.values("number") == (std::vector<std::string>{"1", "2"}));
+    EXPECT(!r.has("levelist"));
+
+    // number: only type=pf/..., never stream=oper/wave
+    EXPECT(!expand.expand(request(text + "stream=enfo,type=an")).has("number"));
+    EXPECT(!expand.expand(request(text + "stream=oper,type=pf")).has("number"));
+    EXPECT(!expand.expand(request(text + "stream=enfo,type=an/pf")).has("number"));
+
+    MarsExpension strict(false, true);
+    EXPECT_THROWS_AS(strict.expand(request(text + "stream=enfo,type=an")), eckit::UserError);
+}
+
+CASE( "test_metkit_expver" ) {
+    MarsExpension expand(false);
+    MarsRequest r = expand.expand(request("retrieve,class=od,param=t,expver=1"));
+    EXPECT(r.values("expver") == std::vector<std::string>{"0001"});
+}
+
+static void regexPatterns(const eckit::Value& v, std::vector<std::string>& patterns) {
+    if (v.isList()) {
+        for (size_t i = 0; i < v.size(); ++i) {
+            regexPatterns(v[i], patterns);
+        }
+    }
+    if (v.isMap()) {
+        eckit::Value keys = v.keys();
+        for (size_t i = 0; i < keys.size(); ++i) {
+            const eckit::Value& value = v[keys[i]];
+            if (std::string(keys[i]) == "regex") {
+                if (value.isList()) {
+                    for (size_t j = 0; j < value.size(); ++j) {
+                        patterns.push_back(value[j]);
+                    }
+                }
+                else {
+                    patterns.push_back(value);
+                }
+            }
+            else {
+                regexPatterns(value, patterns);
+            }
+        }
+    }
+}
+
+CASE( "test_metkit_type_regex" ) {
+    // Patterns are read as eckit::Regex reads them by default: '+', '?', '|' and '{' are plain characters
+    std::vector<std::string> patterns;
+    regexPatterns(eckit::YAMLParser::decodeFile(MarsLanguage::languageYamlFile()), patterns);
+    EXPECT(!patterns.empty());
+    for (const char* p : {"a+b?", "^x\\{2,3\\}$", "[[:digit:]]\\.", "\\(ab\\)\\1"}) {
+        patterns.push_back(p);
+    }
+
+    const std::vector<std::string> corpus = {
+        "", "O", "O0", "O1280", "o640", "F640", "f1", "N640", "xO12", "O12x", "O1+", "o64+", "1.5", "auto", "off",
+        "xx", "xxx", "xxxx", "v1.2", "v1-2", "xabab", "abba", "ab", "aab", "a+b?", "a+b", "ab?",
+    };
+
+    DummyContext ctx;
+    for (const std::string& p : patterns) {
+        eckit::Value settings = eckit::Value::makeMap();
+        settings["regex"]     = p;
+        TypeRegex type("regex", settings);
+        eckit::Regex regex(p);
+
+        // Twice, the second time from the cache
+        for (size_t pass = 0; pass < 2; ++pass) {
+            for (const std::string& s : corpus) {
+                std::string value = s;
+                EXPECT(type.expand(ctx, value) == regex.match(s));
+            }
+        }
+    }
+}
+
+CASE( "test_metkit_expand_ranges" ) {
+    const std::string text = "retrieve,class=od,stream=oper,type=an,levtype=pl,param=t,";
+
+    MarsExpension expand(true);
+    MarsRequest r = expand.expand(request(text + "date=20200130/to/20200302/by/2,time=0/to/18/by/6,levelist=1/to/137"));
+
+    // Ranges are kept symbolic, and give the values of the list written out
+    std::vector<std::string> dates;
+    for (eckit::Date d(20200130); d <= eckit::Date(20200302); d += 2) {
+        dates.push_back(std::to_string(d.yyyymmdd()));
+    }
+    std::vector<std::string> levels;
+    for (size_t i = 1; i <= 137; ++i) {
+        levels.push_back(std::to_string(i));
+    }
+
+    std::ostringstream list;
+    list << text << "date=" << dates[0];
+    for (size_t i = 1; i < dates.size(); ++i) {
+        list << "/" << dates[i];
+    }
+    list << ",time=0000/0600/1200/1800,levelist=1";
+    for (size_t i = 1; i < levels.size(); ++i) {
+        list << "/" << levels[i];
+    }
+
+    MarsExpension eager(true);
+    MarsRequest e = eager.expand(request(list.str()));
+
+    EXPECT(r.parameter(Keyword::id("date"))->range());
+    EXPECT(r.parameter(Keyword::id("time"))->range());
+    EXPECT(r.parameter(Keyword::id("levelist"))->range());
+    EXPECT(!e.parameter(Keyword::id("date"))->range());
+
+    EXPECT(r.countValues("date") == dates.size());
+    EXPECT(r.count() == dates.size() * 4 * 137);
+    EXPECT(r.count() == e.count());
+    EXPECT(r == e);
+    EXPECT(r.values("date") == dates);
+    EXPECT(r.values("levelist") == levels);
+
+    std::ostringstream a, b;
+    r.dump(a);
+    e.dump(b);
+    EXPECT(a.str() == b.str());
+
+    struct Collect : public FlattenCallback {
+        std::vector<std::string> times;
+        void operator()(const MarsRequest& f) { times.push_back(f["time"]); }
+    } collect;
+    expand.flatten(DummyContext(), r.subset({"time"}), collect);
+    EXPECT(collect.times == std::vector<std::string>({"0000", "0600", "1200", "1800"}));
+
+    // Inherited ranges stay symbolic
+    MarsRequest next = expand.expand(request("retrieve,param=u"));
+    EXPECT(next.parameter(Keyword::id("levelist"))->range());
+    EXPECT(next.values("levelist") == levels);
+
+    // Only keywords taking several values get ranges: the others go through expand() and check()
+    Type* single = new TypeDate("date", eckit::Value::makeMap());
+    single->attach();
+    EXPECT(!single->multiple());
+    EXPECT(!single->range(DummyContext(), {"20200101", "to", "20200105"}));
+    single->detach();
+}
+
+CASE( "test_metkit_flatten_cursor" ) {
+    MarsExpension expand(false);
+    MarsRequest r = expand.expand(request("retrieve,class=od,stream=oper,type=an,levtype=pl,param=t/u/v,"
+                                          "date=20200101/to/20200110,time=0/12,levelist=1000/850/500"));
+
+    struct Collect : public FlattenCallback {
+        std::vector<MarsRequest> fields;
+        void operator()(const MarsRequest& f) { fields.push_back(f); }
+    } collect;
+    expand.flatten(DummyContext(), r, collect);
+
+    FlattenCursor cursor = expand.cursor(DummyContext(), r);
+    EXPECT(cursor.size() == 3 * 10 * 2 * 3);
+    EXPECT(cursor.size() == collect.fields.size());
+
+    size_t n = 0;
+    for (; !cursor.done(); cursor.next(), ++n) {
+        FlattenCursor::Field field = cursor.field();
+        EXPECT(field.ordinal() == n);
+        EXPECT(field.request() == collect.fields[n]);
+        EXPECT(field["param"] == collect.fields[n]["param"]);
+        EXPECT(field["stream"] == "oper");
+    }
+    EXPECT(n == collect.fields.size());
+
+    // Jumps land on the same fields as walking
+    FlattenCursor jump = expand.cursor(DummyContext(), r);
+    jump.skip(37);
+    EXPECT(jump.field().request() == collect.fields[37]);
+    jump.next();
+    EXPECT(jump.field().request() == collect.fields[38]);
+    jump.seek(100);
+    EXPECT(jump.field().request() == collect.fields[100]);
+    jump.skip(1000);
+    EXPECT(jump.done());
+
+    // Chunks cover the fields left, in order, once
+    FlattenCursor rest = expand.cursor(DummyContext(), r);
+    rest.skip(5);
+    std::vector<FlattenCursor> chunks = rest.split(7);
+    EXPECT(chunks.size() == 7);
+
+    n = 5;
+    for (auto& chunk : chunks) {
+        EXPECT(chunk.position() == n);
+        for (; !chunk.done(); chunk.next(), ++n) {
+            EXPECT(chunk.field().request() == collect.fields[n]);
+        }
+    }
+    EXPECT(n == collect.fields.size());
+    EXPECT(rest.split(1000).size() == collect.fields.size() - 5);
+}
+
+CASE( "test_metkit_expand_cache" ) {
+    const std::vector<std::string> texts = {
+        "retrieve,class=od,stream=oper,type=an,levtype=pl,param=t/u,date=20200101/to/20200110,levelist=1000/850",
+        "retrieve,param=z",
+        "retrieve,levtype=sfc,param=2t",
+        "retrieve,param=msl,strict=off",
+    };
+
+    std::vector<MarsRequest> expected;
+    {
+        MarsExpension expand(true);
+        for (const auto& text : texts) {
+            expected.push_back(expand.expand(request(text)));
+        }
+    }
+
+    ExpansionCache& cache = ExpansionCache::instance();
+    cache.capacity(100);
+    cache.resetMetrics();
+
+    // The second time round every request is a hit, and leaves the session as expanding it would
+    for (size_t n = 0; n < 2; ++n) {
+        MarsExpension expand(true);
+        for (size_t i = 0; i < texts.size(); ++i) {
+            EXPECT(expand.expand(request(texts[i])) == expected[i]);
+        }
+    }
+
+    ExpansionCache::Metrics m = cache.metrics();
+    EXPECT(m.misses == texts.size());
+    EXPECT(m.hits == texts.size());
+    EXPECT(m.size == texts.size());
+    EXPECT(m.hitRate() == 0.5);
+
+    // What a request inherits is part of the key
+    {
+        MarsExpension expand(true);
+        MarsRequest r = expand.expand(request(texts[1]));
+        EXPECT(!(r == expected[1]));
+        EXPECT(cache.metrics().misses == texts.size() + 1);
+    }
+
+    // Nor is it mixed up with the same request without inheritance, or in strict mode
+    {
+        MarsExpension expand(false);
+        MarsExpension strict(true, true);
+        expand.expand(request(texts[0]));
+        strict.expand(request(texts[0]));
+        EXPECT(cache.metrics().misses == texts.size() + 3);
+    }
+
+    // Relative dates are dates of the day the request is expanded, so entries are only hits on that day
+    {
+        long day = eckit::Date(0).julian();
+        cache.clock([&day] { return day; });
+
+        MarsExpension expand(false);
+        MarsRequest r = expand.expand(request("retrieve,date=0,param=t"));
+        EXPECT(expand.expand(request("retrieve,date=0,param=t")) == r);
+        EXPECT(cache.metrics().misses == texts.size() + 4);
+
+        day++;
+        expand.expand(request("retrieve,date=0,param=t"));
+        EXPECT(cache.metrics().misses == texts.size() + 5);
+
+        cache.clock(std::function<long()>());
+    }
+
+    cache.capacity(2);
+    EXPECT(cache.metrics().size == 2);
+    EXPECT(cache.metrics().evictions == texts.size() + 5 - 2);
+
+    cache.clear();
+    EXPECT(cache.metrics().size == 0);
+
+    cache.capacity(0);
+    EXPECT(!cache.enabled());
+}
+
+CASE( "test_metkit_expand_threads" ) {
+    const std::vector<std::string> texts = {
+        "retrieve,date=20200101,param=t/u/v,levelist=1000/850",
+        "retrieve,type=fc,step=0/to/24/by/6",
+        "retrieve,levtype=sfc,param=2t/msl",
+        "retrieve,class=rd,expver=hl1m,levelist=1/to/10",
+    };
+
+    std::vector<MarsRequest> expected;
+    {
+        MarsExpension expand(true);
+        for (const auto& text : texts) {
+            expected.push_back(expand.expand(request(text)));
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::vector<size_t> errors(8, 0);
+
+    for (size_t t = 0; t < errors.size(); ++t) {
+        threads.emplace_back([&texts, &expected, &errors, t] {
+            for (size_t n = 0; n < 20; ++n) {
+                MarsExpension expand(true);
+                for (size_t i = 0; i < texts.size(); ++i) {
+                    if (!(expand.expand(request(texts[i])) == expected[i])) {
+                        errors[t]++;
+                    }
+                }
+            }
+        });
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (size_t e : errors) {
+        EXPECT(e == 0);
+    }
+}
+
 //-----------------------------------------------------------------------------
 
 }  // namespace test
@@ -0,0 +1,144 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   test_filter.cc
+/// @date   Oct 2026
+
+#include <random>
+
+#include "metkit/mars/Bitset.h"
+#include "metkit/mars/CompiledMarsFilter.h"
+#include "metkit/mars/MarsRequest.h"
+
+#include "eckit/testing/Test.h"
+
+using namespace eckit::testing;
+
+namespace metkit {
+namespace mars {
+namespace test {
+
+//-----------------------------------------------------------------------------
+
+CASE("test_metkit_bitset") {
+    Bitset b(130);
+    EXPECT(b.none());
+
+    b.set(0);
+    b.set(64);
+    b.set(129);
+    EXPECT(b.count() == 3);
+    EXPECT(b.test(64));
+    EXPECT(!b.test(65));
+    EXPECT(b.next(0) == 0);
+    EXPECT(b.next(1) == 64);
+    EXPECT(b.next(65) == 129);
+    EXPECT(b.next(130) == 130);
+
+    Bitset all(130, true);
+    EXPECT(all.count() == 130);
+    all &= b;
+    EXPECT(all == b);
+
+    all.resize(200, true);
+    EXPECT(all.count() == 73);
+    all.resize(65);
+    EXPECT(all.count() == 2);
+}
+
+CASE("test_metkit_compiled_filter") {
+    CompiledMarsFilter filter(MarsRequest::parse("retrieve,class=od,param=t/u"));
+
+    EXPECT(filter.size() == 1);
+    EXPECT(filter.matches(MarsRequest::parse("retrieve,class=od,param=u/v,step=0")));
+    EXPECT(!filter.matches(MarsRequest::parse("retrieve,class=od,param=v")));
+    EXPECT(!filter.matches(MarsRequest::parse("retrieve,param=t")));
+
+    // Matching does not depend on the verb
+    EXPECT(filter.matches(MarsRequest::parse("archive,class=od,param=t")));
+}
+
+CASE("test_metkit_compiled_filter_same_as_matches") {
+    const std::vector<std::string> classes = {"od", "rd", "ea"};
+    const std::vector<std::string> params  = {"t", "u", "v", "q", "z"};
+    const std::vector<std::string> steps   = {"0", "6", "12", "18"};
+
+    std::mt19937 rng(42);
+    auto pick = [&rng](const std::vector<std::string>& values, size_t max) {
+        std::vector<std::string> result;
+        for (const auto& v : values) {
+            if (result.size() < max && rng() % 2) {
+                result.push_back(v);
+            }
+        }
+        return result;
+    };
+
+    auto random = [&](size_t max) {
+        MarsRequest r("retrieve");
+        if (rng() % 4) {
+            r.values("class", pick(classes, max));
+        }
+        if (rng() % 4) {
+            r.values("param", pick(params, max));
+        }
+        if (rng() % 2) {
+            r.values("step", pick(steps, max));
+        }
+        return r;
+    };
+
+    std::vector<MarsRequest> subscriptions;
+    for (size_t i = 0; i < 150; ++i) {
+        subscriptions.push_back(random(3));
+    }
+
+    std::vector<MarsRequest> fields;
+    for (size_t i = 0; i < 200; ++i) {
+        fields.push_back(random(1));
+    }
+
+    CompiledMarsFilter filter(subscriptions);
+    EXPECT(filter.size() == subscriptions.size());
+
+    // Adding the filters one by one grows the bitsets as it goes, to the same results
+    CompiledMarsFilter incremental;
+    for (size_t i = 0; i < subscriptions.size(); ++i) {
+        EXPECT(incremental.add(subscriptions[i]) == i);
+    }
+
+    std::vector<Bitset> results;
+    filter.matches(fields, results);
+    EXPECT(results.size() == fields.size());
+
+    for (size_t j = 0; j < fields.size(); ++j) {
+        Bitset single;
+        filter.matches(fields[j], single);
+        EXPECT(single == results[j]);
+        incremental.matches(fields[j], single);
+        EXPECT(single == results[j]);
+
+        for (size_t i = 0; i < subscriptions.size(); ++i) {
+            bool expected = fields[j].matches(subscriptions[i]);
+            EXPECT(results[j].test(i) == expected);
+            EXPECT(filter.matches(fields[j], i) == expected);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace test
+}  // namespace mars
+}  // namespace metkit
+
+int main(int argc, char** argv) {
+    return run_tests(argc, argv);
+}
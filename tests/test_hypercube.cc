@@ -14,6 +14,7 @@
 
 #include "eckit/types/Date.h"
 #include "metkit/mars/MarsRequest.h"
+#include "metkit/hypercube/Bitmap.h"
 #include "metkit/hypercube/HyperCube.h"
 
 #include "eckit/testing/Test.h"
@@ -114,6 +115,293 @@ CASE( "test_metkit_hypercube_request" ) {
 
 }
 
+CASE( "test_metkit_hypercube_vacant_cover" ) {
+    const char* text = "retrieve,class=rd,type=an,stream=oper,levtype=pl,date=20191110,time=0000,step=0/6/12,expver=xxxy,domain=g,levelist=500/600/700/850,param=138/155/130";
+    MarsRequest r = MarsRequest::parse(text);
+
+    metkit::hypercube::HyperCube cube(r);
+
+    std::vector<MarsRequest> fields;
+    for (const std::string& step : {"0", "6", "12"}) {
+        for (const std::string& levelist : {"500", "600", "700", "850"}) {
+            for (const std::string& param : {"138", "155", "130"}) {
+                MarsRequest field(r);
+                field.setValue("step", step);
+                field.setValue("levelist", levelist);
+                field.setValue("param", param);
+                fields.push_back(field);
+            }
+        }
+    }
+
+    // Scattered holes
+    for (size_t i = 0; i < fields.size(); i += 5) {
+        cube.clear(fields[i]);
+    }
+    cube.clear(fields[13]);
+    EXPECT(cube.countVacant() == 27);
+
+    // The requests cover each vacant field exactly once
+    std::vector<MarsRequest> vacant = cube.vacantRequests();
+    EXPECT(vacant.size() < cube.countVacant());
+
+    size_t total = 0;
+    for (const MarsRequest& v : vacant) {
+        total += metkit::hypercube::HyperCube(v).size();
+        for (const std::string& step : v.values("step")) {
+            for (const std::string& levelist : v.values("levelist")) {
+                for (const std::string& param : v.values("param")) {
+                    MarsRequest field(r);
+                    field.setValue("step", step);
+                    field.setValue("levelist", levelist);
+                    field.setValue("param", param);
+                    EXPECT(cube.contains(field));
+                }
+            }
+        }
+    }
+    EXPECT(total == cube.countVacant());
+}
+
+CASE( "test_metkit_hypercube_batch" ) {
+    const char* text = "retrieve,class=rd,type=an,stream=oper,levtype=pl,date=20191110,time=0000,step=0,expver=xxxy,domain=g,levelist=500/600/700,param=138/155";
+    MarsRequest r = MarsRequest::parse(text);
+
+    metkit::hypercube::HyperCube cube(r);
+
+    std::vector<std::string> names = {"param", "levelist"};
+    for (const std::string& name : r.params()) {
+        if (name != "param" && name != "levelist") {
+            names.push_back(name);
+        }
+    }
+    std::vector<std::vector<std::string>> fields;
+    std::vector<MarsRequest> requests;
+    for (const std::string& param : {"155", "138", "999"}) {
+        for (const std::string& levelist : {"700", "500"}) {
+            fields.push_back({param, levelist});
+            for (size_t i = 2; i < names.size(); ++i) {
+                fields.back().push_back(r.values(names[i])[0]);
+            }
+
+            MarsRequest field(r);
+            field.setValue("param", param);
+            field.setValue("levelist", levelist);
+            requests.push_back(field);
+        }
+    }
+
+    std::vector<size_t> idx = cube.indexOf(names, fields);
+    EXPECT(idx.size() == fields.size());
+    EXPECT(idx[4] == metkit::hypercube::HyperCube::npos);
+    EXPECT(idx[5] == metkit::hypercube::HyperCube::npos);
+
+    for (size_t i = 0; i < idx.size(); ++i) {
+        EXPECT(cube.contains(idx[i]) == cube.contains(requests[i]));
+    }
+
+    EXPECT(cube.clear(idx[0]));
+    EXPECT(!cube.clear(idx[0]));
+    EXPECT(!cube.contains(requests[0]));
+    EXPECT(cube.countVacant() == 5);
+
+    EXPECT_THROWS_AS(cube.indexOf({"param"}, {{"138"}}), eckit::UserError);
+}
+
+CASE( "test_metkit_hypercube_ordinal" ) {
+    const char* text = "retrieve,class=rd,type=an,stream=oper,levtype=pl,date=20191110,time=0000,step=0,expver=xxxy,domain=g,levelist=500/600/700,param=138/155";
+    MarsRequest r = MarsRequest::parse(text);
+
+    metkit::hypercube::HyperCube cube(r);
+
+    std::vector<MarsRequest> fields;
+    for (const std::string& levelist : {"500", "600", "700"}) {
+        for (const std::string& param : {"138", "155"}) {
+            MarsRequest field(r);
+            field.setValue("levelist", levelist);
+            field.setValue("param", param);
+            fields.push_back(field);
+        }
+    }
+
+    cube.clear(fields[1]);
+    cube.clear(fields[4]);
+
+    std::vector<size_t> expected = {0, 1, 1, 2, 3, 3};
+    for (size_t i = 0; i < fields.size(); ++i) {
+        EXPECT(cube.fieldOrdinal(fields[i], false) == i);
+        EXPECT(cube.fieldOrdinal(fields[i]) == expected[i]);
+    }
+}
+
+CASE( "test_metkit_hypercube_bitmap" ) {
+    metkit::hypercube::Bitmap b(1000, true);
+    EXPECT(b.count() == 1000);
+
+    for (size_t i = 0; i < 1000; i += 3) {
+        EXPECT(b.reset(i));
+    }
+    EXPECT(!b.reset(0));
+    EXPECT(b.count() == 666);
+
+    size_t n = 0;
+    for (size_t i = b.next(0); i < b.size(); i = b.next(i + 1)) {
+        EXPECT(b.rank(i) == n);
+        EXPECT(b.select(n) == i);
+        n++;
+    }
+    EXPECT(n == b.count());
+    EXPECT(b.rank(1000) == 666);
+    EXPECT(b.select(666) == 1000);
+
+    EXPECT(b.set(999));
+    EXPECT(b.rank(1000) == 667);
+}
+
+CASE( "test_metkit_hypercube_bitmap_sparse" ) {
+    // Four chunks of 65536 bits, the last one partial, going through each representation
+    const size_t size = 3 * 65536 + 1000;
+    metkit::hypercube::Bitmap b(size);
+    std::vector<bool> reference(size, false);
+
+    auto check = [&]() {
+        size_t n = 0;
+        for (size_t i = 0; i < size; ++i) {
+            EXPECT(b.test(i) == reference[i]);
+            EXPECT(b.rank(i) == n);
+            if (reference[i]) {
+                EXPECT(b.select(n) == i);
+                EXPECT(b.next(i) == i);
+                n++;
+            }
+        }
+        EXPECT(b.count() == n);
+        EXPECT(b.select(n) == size);
+    };
+
+    // Sparse in the first chunk, dense in the second, almost full in the third
+    for (size_t i = 0; i < 65536; i += 97) {
+        EXPECT(b.set(i));
+        reference[i] = true;
+    }
+    for (size_t i = 65536; i < 2 * 65536; i += 3) {
+        b.set(i);
+        reference[i] = true;
+    }
+    for (size_t i = 2 * 65536; i < 3 * 65536; ++i) {
+        b.set(i);
+        reference[i] = (i % 1001 != 0);
+        if (!reference[i]) {
+            EXPECT(b.reset(i));
+        }
+    }
+    check();
+
+    EXPECT(b.next(3 * 65536) == size);
+
+    // Back to sparse, then empty
+    for (size_t i = 65536; i < 2 * 65536; ++i) {
+        if (i % 300 != 0) {
+            b.reset(i);
+            reference[i] = false;
+        }
+    }
+    for (size_t i = 2 * 65536; i < 3 * 65536; ++i) {
+        b.reset(i);
+        reference[i] = false;
+    }
+    check();
+}
+
+CASE( "test_metkit_hypercube_large" ) {
+    // 1000 dates x 1000 steps x 100 levels x 100 params, more fields than a 32-bit index reaches
+    std::vector<std::string> names = {"date", "step", "levelist", "param"};
+    std::vector<size_t> sizes      = {1000, 1000, 100, 100};
+
+    MarsRequest r("retrieve");
+    for (size_t i = 0; i < names.size(); ++i) {
+        std::vector<std::string> values;
+        for (size_t j = 0; j < sizes[i]; ++j) {
+            values.push_back(std::to_string(j + 1));
+        }
+        r.values(names[i], values);
+    }
+
+    metkit::hypercube::HyperCube cube(r);
+    EXPECT(cube.size() == size_t(10000000000));
+    EXPECT(cube.countVacant() == cube.size());
+
+    // Far less than one bit per field while it has no holes
+    EXPECT(cube.footprint() < cube.size() / 64);
+
+    MarsRequest first("retrieve");
+    MarsRequest last("retrieve");
+    for (size_t i = 0; i < names.size(); ++i) {
+        first.setValue(names[i], "1");
+        last.setValue(names[i], std::to_string(sizes[i]));
+    }
+
+    std::vector<size_t> idx = cube.indexOf(names, {{"1000", "1000", "100", "100"}, {"1001", "1", "1", "1"}});
+    EXPECT(idx[0] == cube.size() - 1);
+    EXPECT(idx[1] == metkit::hypercube::HyperCube::npos);
+
+    EXPECT(cube.clear(first));
+    EXPECT(cube.countVacant() == cube.size() - 1);
+    EXPECT(!cube.contains(first));
+    EXPECT(cube.contains(idx[0]));
+    EXPECT(cube.fieldOrdinal(last, false) == cube.size() - 1);
+    EXPECT(cube.fieldOrdinal(last) == cube.size() - 2);
+}
+
+CASE( "test_metkit_hypercube_algebra" ) {
+    using namespace metkit::hypercube;
+
+    auto fields = [](const std::vector<MarsRequest>& requests) {
+        size_t n = 0;
+        for (const MarsRequest& r : requests) {
+            n += HyperCube(r).size();
+        }
+        return n;
+    };
+
+    std::vector<MarsRequest> a = {MarsRequest::parse("retrieve,class=rd,type=an,stream=oper,levtype=pl,date=20191110,time=0000,step=0,expver=xxxy,domain=g,levelist=500/600,param=138/155")};
+    std::vector<MarsRequest> b = {MarsRequest::parse("retrieve,class=rd,type=an,stream=oper,levtype=pl,date=20191110,time=0000,step=0,expver=xxxy,domain=g,levelist=600/700,param=155")};
+    std::vector<MarsRequest> sfc = {MarsRequest::parse("retrieve,class=rd,type=an,stream=oper,levtype=sfc,date=20191110,time=0000,step=0,expver=xxxy,domain=g,param=167")};
+
+    std::vector<MarsRequest> both = intersect(a, b);
+    EXPECT(both.size() == 1);
+    EXPECT(both[0].values("levelist") == std::vector<std::string>{"600"});
+    EXPECT(both[0].values("param") == std::vector<std::string>{"155"});
+
+    EXPECT(fields(subtract(a, b)) == 3);
+    EXPECT(fields(subtract(b, a)) == 1);
+    EXPECT(fields(unite(a, b)) == 5);
+    EXPECT(subtract(a, a).empty());
+    EXPECT(unite(a, a).size() == 1);
+
+    // Requests of a list may overlap
+    std::vector<MarsRequest> ab = {a[0], b[0]};
+    EXPECT(fields(intersect(ab, a)) == 4);
+    EXPECT(fields(subtract(ab, a)) == 1);
+
+    // Without levelist, these are other fields
+    EXPECT(intersect(a, sfc).empty());
+    EXPECT(fields(subtract(sfc, a)) == 1);
+    EXPECT(fields(unite(a, sfc)) == 5);
+
+    // A cube stands for its vacant fields
+    HyperCube cubeA(a[0]);
+    HyperCube cubeB(b[0]);
+    MarsRequest field(a[0]);
+    field.setValue("levelist", "600");
+    field.setValue("param", "155");
+    cubeA.clear(field);
+
+    EXPECT(intersect(cubeA, cubeB).empty());
+    EXPECT(fields(subtract(cubeA, cubeB)) == 3);
+    EXPECT(fields(unite(cubeA, cubeB)) == 5);
+}
+
 //-----------------------------------------------------------------------------
 
 }  // namespace test
@@ -591,6 +591,36 @@ CASE ("table15") {
     test_param_axis(user, axis, expect, false);
 }
 
+CASE ("reused index") {
+
+    std::vector<Param> axis = {Param("210131"), Param("133.170"), Param("180134"), Param("131.170"), Param("160132"), Param("138"), Param("155")};
+    std::sort(axis.begin(), axis.end());
+
+    const ParamID::Index index(axis);
+    MarsRequest ignore;
+
+    // Same results as with the axis itself, for several requests against the same index
+    for (const std::vector<std::string>& user : std::vector<std::vector<std::string>>{{"134", "133"}, {"131", "132"}, {"134", "133.128"}, {"131.128"}}) {
+        for (bool fullTableDropping : {false, true}) {
+            std::vector<Param> params(user.begin(), user.end());
+            std::vector<Param> expected(user.begin(), user.end());
+            bool wind = false;
+            bool expectWind = false;
+
+            ParamID::normalise(ignore, params, index, wind, fullTableDropping);
+            ParamID::normalise(ignore, expected, axis, expectWind, fullTableDropping);
+
+            EXPECT(params == expected);
+            EXPECT(wind == expectWind);
+        }
+    }
+
+    std::vector<Param> params = {Param("134"), Param("133")};
+    bool wind = false;
+    ParamID::normalise(ignore, params, index, wind, true);
+    EXPECT(params == (std::vector<Param>{Param("180134"), Param("133.170")}));
+}
+
 }  // namespace test
 }  // namespace mars
 }  // namespace metkit
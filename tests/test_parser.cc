@@ -0,0 +1,123 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   test_parser.cc
+/// @date   Oct 2026
+
+#include <fstream>
+#include <sstream>
+
+#include "eckit/filesystem/PathName.h"
+#include "eckit/filesystem/TmpFile.h"
+
+#include "metkit/mars/MarsParser.h"
+
+#include "eckit/testing/Test.h"
+
+using namespace eckit::testing;
+
+namespace metkit {
+namespace mars {
+namespace test {
+
+//-----------------------------------------------------------------------------
+
+static std::vector<MarsParsedRequest> streamParse(const std::string& text) {
+    std::istringstream in(text);
+    MarsParser parser(in);
+    return parser.parse();
+}
+
+static void same(const std::vector<MarsParsedRequest>& a, const std::vector<MarsParsedRequest>& b) {
+    EXPECT(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        EXPECT(a[i].verb() == b[i].verb());
+        EXPECT(a[i] == b[i]);
+    }
+}
+
+CASE("test_metkit_buffer_parser") {
+    const std::vector<std::string> inputs = {
+        "retrieve,class=od,param=t/u/v,date=-1",
+        "retrieve, class = od , levelist = 1000 / 850 ,\n  param = 130.128",
+        "list,expver=\"0001\",target='out file.grib',date=\"a\\\"b\\\\c\\/d\\te\"",
+        "# comment\nretrieve, # trailing comment\n  class=od # another\n, param=2t",
+        "retrieve,grid=regular  ll,area=Europe   Central",
+        "retrieve,class=od\nretrieve,class=rd\n\n_archive,expver=1",
+        "",
+        "   \n# only a comment",
+        "retrieve,target=\"a # b\" # comment\n,expver='#1'#\n",
+        "retrieve,grid=regular ll# comment\n,area=\"Europe # Central\"/North   West",
+    };
+
+    for (const auto& text : inputs) {
+        MarsBufferParser parser(text);
+        same(parser.parse(), streamParse(text));
+    }
+
+    const std::string text = "retrieve,target=\"a\\tb\",grid=1 2   3";
+    MarsBufferParser parser(text);
+    auto requests = parser.parse();
+    EXPECT(requests.size() == 1);
+    EXPECT(requests[0].values("target")[0] == "a\tb");
+    EXPECT(requests[0].values("grid")[0] == "1 2 3");
+
+    // Comments only start between tokens, not inside quoted values, with either parser
+    const std::string comment = "retrieve,target=\"a # b\" # comment";
+    MarsBufferParser quoted(comment);
+    requests = quoted.parse();
+    EXPECT(requests.size() == 1);
+    EXPECT(requests[0].values("target")[0] == "a # b");
+    EXPECT(streamParse(comment)[0].values("target")[0] == "a # b");
+}
+
+CASE("test_metkit_buffer_parser_errors") {
+    const std::vector<std::string> inputs = {
+        "1retrieve,class=od",
+        "retrieve,class od",
+        "retrieve,target=\"unterminated",
+        "retrieve,target=\"bad \\x escape\"",
+        "retrieve,target=\"\\u0041\"",
+    };
+
+    for (const auto& text : inputs) {
+        MarsBufferParser parser(text);
+        EXPECT_THROWS_AS(parser.parse(), eckit::StreamParser::Error);
+        EXPECT_THROWS_AS(streamParse(text), eckit::StreamParser::Error);
+    }
+}
+
+CASE("test_metkit_buffer_parser_file") {
+    const std::string text = "retrieve,class=od,param=t\n# comment\nretrieve,class=rd,param=\"u\"\n";
+
+    eckit::TmpFile file;
+    {
+        std::ofstream out(file.asString().c_str());
+        out << text;
+    }
+
+    MarsBufferParser parser(file);
+    same(parser.parse(), streamParse(text));
+
+    eckit::TmpFile empty;
+    std::ofstream(empty.asString().c_str()).close();
+    MarsBufferParser none(empty);
+    EXPECT(none.parse().empty());
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace test
+}  // namespace mars
+}  // namespace metkit
+
+int main(int argc, char** argv) {
+    return run_tests(argc, argv);
+}
@@ -0,0 +1,473 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   test_request.cc
+/// @date   Oct 2026
+
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <unordered_set>
+
+#include "metkit/mars/Keyword.h"
+#include "metkit/mars/MarsExpandContext.h"
+#include "metkit/mars/MarsRequest.h"
+#include "metkit/mars/MarsRequestView.h"
+#include "metkit/mars/StringPool.h"
+#include "metkit/mars/TypeAny.h"
+#include "metkit/mars/TypeDate.h"
+
+#include "eckit/io/Buffer.h"
+#include "eckit/serialisation/MemoryStream.h"
+#include "eckit/testing/Test.h"
+#include "eckit/utils/MD5.h"
+
+using namespace eckit::testing;
+
+//-----------------------------------------------------------------------------
+
+/// Counts heap allocations, to check that values are moved rather than copied
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace metkit {
+namespace mars {
+namespace test {
+
+//-----------------------------------------------------------------------------
+
+static MarsRequest sample() {
+    MarsRequest r("retrieve");
+    r.setValue("class", "od");
+    r.setValue("stream", "oper");
+    r.values("param", {"t", "u", "v"});
+    r.setValue("date", 20200101L);
+    return r;
+}
+
+CASE("test_metkit_request_lookup") {
+    MarsRequest r = sample();
+
+    EXPECT(r.has("class"));
+    EXPECT(r.has("param"));
+    EXPECT(!r.has("levelist"));
+    EXPECT(!r.has("never-registered-keyword"));
+
+    EXPECT(r.is("stream", "oper"));
+    EXPECT(!r.is("param", "t"));
+    EXPECT(r.countValues("param") == 3);
+    EXPECT(r.countValues("levelist") == 0);
+    EXPECT(r.values("levelist", true).empty());
+    EXPECT_THROWS(r.values("levelist"));
+    EXPECT(r["date"] == "20200101");
+
+    // Keywords are found whatever their ids, including those registered after the others
+    for (size_t i = 0; i < 100; ++i) {
+        Keyword::id("test-keyword-" + std::to_string(i));
+    }
+    r.setValue("test-keyword-99", "x");
+    r.setValue("test-keyword-3", "y");
+    EXPECT(r.is("test-keyword-99", "x"));
+    EXPECT(r.is("test-keyword-3", "y"));
+    EXPECT(!r.has("test-keyword-50"));
+    EXPECT(r.parameter(Keyword::id("class"))->values()[0] == "od");
+    EXPECT(!r.parameter(Keyword::id("test-keyword-50")));
+}
+
+CASE("test_metkit_request_order") {
+    MarsRequest r = sample();
+
+    std::vector<std::string> params = r.params();
+    EXPECT(params.size() == 4);
+    EXPECT(params[0] == "class");
+    EXPECT(params[1] == "stream");
+    EXPECT(params[2] == "param");
+    EXPECT(params[3] == "date");
+
+    std::ostringstream oss;
+    oss << r;
+    EXPECT(oss.str() == "retrieve,class=od,stream=oper,param=t/u/v,date=20200101");
+
+    // Updating a value keeps its position, re-adding it moves it last
+    r.setValue("class", "rd");
+    r.unsetValues("stream");
+    r.setValue("stream", "enfo");
+
+    params = r.params();
+    EXPECT(params.size() == 4);
+    EXPECT(params[0] == "class");
+    EXPECT(params[1] == "param");
+    EXPECT(params[2] == "date");
+    EXPECT(params[3] == "stream");
+
+    EXPECT(r.is("class", "rd"));
+    EXPECT(r.is("stream", "enfo"));
+    EXPECT(r.countValues("param") == 3);
+}
+
+CASE("test_metkit_request_copy") {
+    MarsRequest r = sample();
+    MarsRequest c(r);
+
+    EXPECT(!(r < c));
+    EXPECT(!(c < r));
+
+    c.setValue("class", "rd");
+    EXPECT(r.is("class", "od"));
+    EXPECT(c.is("class", "rd"));
+
+    MarsRequest s = r.subset({"date", "param"});
+    EXPECT(s.params().size() == 2);
+    EXPECT(s.countValues("param") == 3);
+    EXPECT(!s.has("class"));
+}
+
+CASE("test_metkit_string_pool") {
+    StringPool pool;
+
+    const StringPool::Entry& od = pool.intern("od");
+    const StringPool::Entry& fc = pool.intern("fc");
+
+    EXPECT(&pool.intern("od") == &od);
+    EXPECT(pool.find("fc") == &fc);
+    EXPECT(pool.find("an") == nullptr);
+    EXPECT(od.id() == 0);
+    EXPECT(fc.id() == 1);
+    EXPECT(pool.size() == 2);
+    EXPECT(od.str() == "od");
+    EXPECT(od.list().size() == 1);
+}
+
+CASE("test_metkit_string_pool_limit") {
+    StringPool pool;
+    pool.intern("od");
+
+    // A full pool still finds what it holds, but takes no more
+    EXPECT(pool.intern("od", 1) == pool.find("od"));
+    EXPECT(pool.intern("fc", 1) == nullptr);
+    EXPECT(pool.size() == 1);
+    EXPECT(pool.intern("fc", 2) != nullptr);
+
+    // Lists of dates are checked for duplicates without going through the pool
+    MarsRequest r = MarsRequest::parse("retrieve,date=19370101/19370102,param=t");
+    EXPECT(r.values("date").size() == 2);
+    EXPECT(StringPool::values().find("19370101") == nullptr);
+}
+
+CASE("test_metkit_request_interned_values") {
+    Type* date = new TypeDate("date", eckit::Value());
+    date->attach();
+
+    MarsRequest r("retrieve");
+    r.setValuesTyped(date, {"20200101"});
+    MarsRequest s(r);
+
+    // Single values of interned types share the pooled list
+    EXPECT(&r.values("date") == &s.values("date"));
+    EXPECT(&r.values("date") == &StringPool::values().intern("20200101").list());
+
+    r.setValuesTyped(date, {"20200101", "20200102", "20200103"});
+    EXPECT(r.countValues("date") == 3);
+    EXPECT(s.countValues("date") == 1);
+
+    r.filter(s);
+    EXPECT(r.is("date", "20200101"));
+    EXPECT(&r.values("date") == &s.values("date"));
+
+    date->detach();
+}
+
+CASE("test_metkit_request_copy_on_write") {
+    MarsRequest r = sample();
+    MarsRequest s(r);
+
+    // Copies share their value lists until one of them is modified
+    EXPECT(&r.values("param") == &s.values("param"));
+
+    s.setValue("param", "z");
+    EXPECT(r.countValues("param") == 3);
+    EXPECT(s.countValues("param") == 1);
+
+    MarsRequest t(r);
+    t.filter(MarsRequest::parse("retrieve,param=t/v"));
+    EXPECT(t.countValues("param") == 2);
+    EXPECT(r.countValues("param") == 3);
+    EXPECT(&r.values("class") == &t.values("class"));
+
+    MarsRequest u(r);
+    u.merge(MarsRequest::parse("retrieve,param=q"));
+    EXPECT(u.countValues("param") == 4);
+    EXPECT(r.countValues("param") == 3);
+}
+
+CASE("test_metkit_request_merge") {
+    MarsRequest r = MarsRequest::parse("retrieve,param=t/u,step=0");
+    r.merge(MarsRequest::parse("retrieve,param=v/t/w,step=0,levelist=500"));
+
+    EXPECT(r.values("param") == std::vector<std::string>({"t", "u", "v", "w"}));
+    EXPECT(r.values("step") == std::vector<std::string>({"0"}));
+    EXPECT(!r.has("levelist"));
+
+    // Long lists take the hashed path, with the same result
+    std::vector<std::string> a;
+    std::vector<std::string> b;
+    std::vector<std::string> expected;
+    for (size_t i = 0; i < 100; ++i) {
+        a.push_back(std::to_string(i));
+        b.push_back(std::to_string(99 - 2 * long(i)));
+    }
+    expected = a;
+    for (size_t i = 0; i < 100; ++i) {
+        long v = 99 - 2 * long(i);
+        if (v < 0) {
+            expected.push_back(std::to_string(v));
+        }
+    }
+
+    MarsRequest x("retrieve");
+    x.values("step", a);
+    MarsRequest y("retrieve");
+    y.values("step", b);
+    x.merge(y);
+    EXPECT(x.values("step") == expected);
+}
+
+CASE("test_metkit_request_merge_all") {
+    std::vector<MarsRequest> requests;
+    for (size_t i = 0; i < 200; ++i) {
+        MarsRequest r("retrieve");
+        r.setValue("date", long(20200101 + i % 50));
+        r.setValue("param", (i % 3) ? "t" : "u");
+        r.setValue("step", long(i));
+        requests.push_back(r);
+    }
+
+    MarsRequest one = requests.front();
+    for (const auto& r : requests) {
+        one.merge(r);
+    }
+
+    MarsRequest all = requests.front();
+    all.mergeAll(requests);
+
+    EXPECT(one == all);
+    EXPECT(all.countValues("date") == 50);
+    EXPECT(all.countValues("step") == 200);
+    EXPECT(all.values("param") == std::vector<std::string>({"u", "t"}));
+}
+
+CASE("test_metkit_request_view") {
+    MarsRequest r = sample();
+    r.setValue("target", "data file.grib");
+    MarsRequest s = MarsRequest::parse("list,class=rd,expver=abcd");
+
+    // Two requests back to back, as in a batch
+    eckit::Buffer buffer(4096);
+    eckit::MemoryStream out(buffer.data(), buffer.size());
+    out << r << s;
+    size_t length = out.position();
+
+    MarsRequestView v(buffer.data(), length);
+    EXPECT(v.verb() == "retrieve");
+    EXPECT(v.has("param"));
+    EXPECT(!v.has("levelist"));
+    EXPECT(v.countValues("param") == 3);
+    EXPECT(v.values("param")[2] == "v");
+    EXPECT(v.values("target")[0] == "data file.grib");
+    EXPECT(v.values("levelist").empty());
+
+    std::vector<std::string> params;
+    for (auto p : v.params()) {
+        params.emplace_back(p);
+    }
+    EXPECT(params == r.params());
+
+    std::vector<std::string> values;
+    for (auto p : v.values("param")) {
+        values.emplace_back(p);
+    }
+    EXPECT(values == r.values("param"));
+
+    EXPECT(v.request() == r);
+
+    size_t size = v.encodedSize();
+    MarsRequestView w(static_cast<const char*>(buffer.data()) + size, length - size);
+    EXPECT(w.verb() == "list");
+    EXPECT(w.values("expver")[0] == "abcd");
+    EXPECT(w.encodedSize() == length - size);
+    EXPECT(w.request() == s);
+
+    EXPECT_THROWS(MarsRequestView(buffer.data(), size / 2).encodedSize());
+}
+
+CASE("test_metkit_request_view_stream") {
+    // The view reads the eckit::Stream encoding directly: strings and ints as it writes them
+    {
+        eckit::Buffer buffer(64);
+        eckit::MemoryStream out(buffer.data(), buffer.size());
+        out << std::string("ab");
+        out << int(258);
+        EXPECT(out.position() == 12);
+
+        const unsigned char* u = static_cast<const unsigned char*>(buffer.data());
+        const std::vector<unsigned char> expected = {15, 0, 0, 0, 2, 'a', 'b', 5, 0, 0, 1, 2};
+        EXPECT(std::vector<unsigned char>(u, u + 12) == expected);
+    }
+
+    // Requests written by eckit::Stream, read back by the view and by MarsRequest(eckit::Stream&)
+    std::vector<MarsRequest> requests;
+    requests.emplace_back("list");
+
+    MarsRequest r("retrieve");
+    r.setValue("empty", "");
+    r.setValue("long", std::string(300, 'x'));
+    std::vector<std::string> many;
+    for (size_t i = 0; i < 1000; ++i) {
+        many.push_back(std::to_string(i));
+    }
+    r.values("many", many);
+    for (size_t i = 0; i < 300; ++i) {
+        r.setValue("key" + std::to_string(i), long(i));
+    }
+    requests.push_back(r);
+    requests.push_back(sample());
+
+    eckit::Buffer buffer(65536);
+    eckit::MemoryStream out(buffer.data(), buffer.size());
+    for (const auto& request : requests) {
+        out << request;
+    }
+    size_t length = out.position();
+
+    eckit::MemoryStream in(buffer.data(), length);
+    const char* p   = static_cast<const char*>(buffer.data());
+    const char* end = p + length;
+    for (const auto& request : requests) {
+        MarsRequest decoded(in);
+        MarsRequestView v(p, end - p);
+        EXPECT(decoded == request);
+        EXPECT(v.request() == request);
+        EXPECT(v.countValues("many") == request.countValues("many"));
+        p += v.encodedSize();
+    }
+    EXPECT(p == end);
+    EXPECT(in.position() == length);
+}
+
+CASE("test_metkit_request_md5") {
+    MarsRequest r = sample();
+    r.setValue("target", "data file.grib");
+
+    std::ostringstream oss;
+    oss << r;
+
+    eckit::MD5 streamed;
+    r.md5(streamed);
+
+    EXPECT(streamed.digest() == eckit::MD5(oss.str()).digest());
+}
+
+CASE("test_metkit_request_hash") {
+    MarsRequest r = sample();
+    MarsRequest s = sample();
+
+    EXPECT(r == s);
+    EXPECT(r.hash() == s.hash());
+    EXPECT(std::hash<MarsRequest>()(r) == r.hash());
+
+    // The cached hash follows mutations
+    s.setValue("stream", "enfo");
+    EXPECT(r != s);
+    EXPECT(r.hash() != s.hash());
+
+    s.setValue("stream", "oper");
+    EXPECT(r == s);
+    EXPECT(r.hash() == s.hash());
+
+    s.verb("list");
+    EXPECT(r != s);
+
+    std::unordered_set<MarsRequest> requests;
+    requests.insert(r);
+    requests.insert(sample());
+    requests.insert(s);
+    EXPECT(requests.size() == 2);
+}
+
+CASE("test_metkit_request_move_values") {
+    // Values longer than the small string buffer, so that every string copy allocates
+    const std::string value(64, 'x');
+
+    Type* any = new TypeAny("target", eckit::Value());
+    any->attach();
+
+    {
+        std::vector<std::string> values(100, value);
+
+        size_t before = allocations;
+        Parameter p(std::move(values), any);
+        EXPECT(allocations - before == 1);  // the shared value block
+        EXPECT(p.values().size() == 100);
+    }
+
+    {
+        // The expansion hot path: expand in place, then move into the request
+        MarsRequest r("retrieve");
+        std::vector<std::string> values(1, value);
+        const char* data = values[0].data();
+
+        DummyContext ctx;
+
+        size_t before = allocations;
+        any->expand(ctx, values);
+        r.setValuesTyped(any, std::move(values));
+        EXPECT(allocations - before <= 3);  // the value block, and room in the parameter table and index
+
+        EXPECT(r.values("target")[0].data() == data);
+    }
+
+    {
+        MarsRequest r("retrieve");
+        r.setValue("target", value);
+
+        std::vector<std::string> values(10, value);
+        size_t before = allocations;
+        r.values("target", std::move(values));
+        EXPECT(allocations - before == 1);
+        EXPECT(r.countValues("target") == 10);
+    }
+
+    any->detach();
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace test
+}  // namespace mars
+}  // namespace metkit
+
+int main(int argc, char** argv) {
+    return run_tests(argc, argv);
+}
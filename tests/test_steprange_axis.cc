@@ -110,6 +110,19 @@ CASE("match range start") {
     test_steprange_axis(user, axis, expect);
 }
 
+CASE("reused index") {
+    std::vector<StepRange> axis = {StepRange("1"), StepRange("0-1"), StepRange("3"), StepRange("0-3"), StepRange("0-24"), StepRange("25")};
+    const StepRangeNormalise::Index index(axis);
+
+    std::vector<StepRange> values = {StepRange("1"), StepRange("2"), StepRange("24"), StepRange("25")};
+    StepRangeNormalise::normalise(values, index);
+    EXPECT(values == (std::vector<StepRange>{StepRange("1"), StepRange("0-1"), StepRange("0-24"), StepRange("25")}));
+
+    values = {StepRange("3")};
+    StepRangeNormalise::normalise(values, index);
+    EXPECT(values == (std::vector<StepRange>{StepRange("3"), StepRange("0-3")}));
+}
+
 
 }  // namespace test
 }  // namespace mars
@@ -0,0 +1,178 @@
+/*
+ * (C) Copyright 1996- ECMWF.
+ *
+ * This software is licensed under the terms of the Apache Licence Version 2.0
+ * which can be obtained at http://www.apache.org/licenses/LICENSE-2.0.
+ * In applying this licence, ECMWF does not waive the privileges and immunities
+ * granted to it by virtue of its status as an intergovernmental organisation
+ * nor does it submit to any jurisdiction.
+ */
+
+/// @file   test_yaml_cache.cc
+/// @date   Oct 2026
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+
+#include "eckit/filesystem/PathName.h"
+#include "eckit/filesystem/TmpFile.h"
+#include "eckit/parser/YAMLParser.h"
+
+#include "metkit/config/LibMetkit.h"
+#include "metkit/mars/MarsLanguage.h"
+#include "metkit/mars/YAMLCache.h"
+
+#include "eckit/testing/Test.h"
+
+using namespace eckit::testing;
+
+namespace metkit {
+namespace mars {
+namespace test {
+
+//-----------------------------------------------------------------------------
+
+static const char* yaml = R"(
+retrieve:
+  class: [od, rd]
+  step: 12
+  grid: 0.25
+  quiet: true
+  missing: ~
+  nested:
+    zebra: 1
+    alpha: [a, 2, 3.5]
+  130: t
+)";
+
+static void same(const eckit::Value& a, const eckit::Value& b) {
+    EXPECT(a == b);
+    EXPECT(a.isOrderedMap() == b.isOrderedMap());
+    if (a.isOrderedMap() || a.isMap()) {
+        EXPECT(a.keys() == b.keys());
+    }
+}
+
+CASE("test_metkit_yaml_cache_encoding") {
+    eckit::Value value = eckit::YAMLParser::decodeString(yaml);
+
+    std::string encoded  = YAMLCache::encode(value);
+    eckit::Value decoded = YAMLCache::decode(encoded.data(), encoded.size());
+    same(decoded, value);
+    same(decoded["retrieve"]["nested"], value["retrieve"]["nested"]);
+
+    EXPECT_THROWS_AS(YAMLCache::decode(encoded.data(), encoded.size() - 1), eckit::BadValue);
+    encoded += 'n';
+    EXPECT_THROWS_AS(YAMLCache::decode(encoded.data(), encoded.size()), eckit::BadValue);
+
+    // Counts larger than what is left are rejected before anything is allocated
+    for (char tag : {'l', 'm', 'o'}) {
+        std::string damaged(1, tag);
+        damaged.append(4, char(0xff));
+        damaged += 'n';
+        EXPECT_THROWS_AS(YAMLCache::decode(damaged.data(), damaged.size()), eckit::BadValue);
+    }
+}
+
+CASE("test_metkit_yaml_cache_file") {
+    eckit::TmpFile file;
+    {
+        std::ofstream out(file.asString().c_str());
+        out << yaml;
+    }
+
+    eckit::PathName cache = YAMLCache::cacheFile(file);
+    EXPECT(!cache.exists());
+
+    eckit::Value expected = eckit::YAMLParser::decodeFile(file);
+
+    same(YAMLCache::decodeFile(file), expected);
+    EXPECT(cache.exists());
+
+    // Served from the cache
+    same(YAMLCache::decodeFile(file), expected);
+
+    // A change of the YAML file makes the cache stale
+    {
+        std::ofstream out(file.asString().c_str(), std::ios::app);
+        out << "list:\n  target: out\n";
+    }
+    eckit::Value changed = YAMLCache::decodeFile(file);
+    same(changed, eckit::YAMLParser::decodeFile(file));
+    EXPECT(changed.contains("list"));
+
+    // As is a change that keeps the size, made within the same second. The clock of the file system may be
+    // coarser than a nanosecond, so the times are set explicitly, one nanosecond apart
+    auto touch = [&file](long nsec) {
+        struct timespec times[2] = {{0, UTIME_OMIT}, {1700000000, nsec}};
+        EXPECT(::utimensat(AT_FDCWD, file.localPath(), times, 0) == 0);
+    };
+
+    touch(0);
+    same(YAMLCache::decodeFile(file), changed);
+    {
+        std::string edited(yaml);
+        edited.replace(edited.find("zebra"), 5, "zebru");
+        std::ofstream out(file.asString().c_str(), std::ios::trunc);
+        out << edited << "list:\n  target: out\n";
+    }
+    touch(1);
+    changed = YAMLCache::decodeFile(file);
+    same(changed, eckit::YAMLParser::decodeFile(file));
+    EXPECT(changed["retrieve"]["nested"].contains("zebru"));
+
+    // A corrupted cache is ignored and rewritten
+    {
+        std::ofstream out(cache.asString().c_str(), std::ios::trunc);
+        out << "garbage";
+    }
+    same(YAMLCache::decodeFile(file), changed);
+    same(YAMLCache::decodeFile(file), changed);
+
+    ::unlink(cache.localPath());
+}
+
+CASE("test_metkit_yaml_cache_language") {
+    eckit::PathName path = MarsLanguage::languageYamlFile();
+    same(YAMLCache::update(path), eckit::YAMLParser::decodeFile(path));
+    same(YAMLCache::decodeFile(path), eckit::YAMLParser::decodeFile(path));
+
+    // Written to the cache directory, not next to the installed file
+    eckit::PathName cache = YAMLCache::cacheFile(path);
+    EXPECT(cache.exists());
+    EXPECT(cache.dirName().asString() != path.dirName().asString());
+    ::unlink(cache.localPath());
+}
+
+//-----------------------------------------------------------------------------
+
+}  // namespace test
+}  // namespace mars
+}  // namespace metkit
+
+int main(int argc, char** argv) {
+    // A cache directory of its own, made by the first update()
+    char dir[] = "/tmp/metkit_yaml_cache_XXXXXX";
+    ASSERT(::mkdtemp(dir));
+    ::rmdir(dir);
+    ::setenv("METKIT_CACHE_DIR", dir, 1);
+
+    int result = run_tests(argc, argv);
+
+    // Including the caches of the files read by the library itself
+    if (eckit::PathName(dir).exists()) {
+        std::vector<eckit::PathName> files;
+        std::vector<eckit::PathName> directories;
+        eckit::PathName(dir).children(files, directories);
+        for (const auto& f : files) {
+            f.unlink();
+        }
+        ::rmdir(dir);
+    }
+
+    return result;
+}